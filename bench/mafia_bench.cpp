@@ -0,0 +1,374 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <optional>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include "Game.h"
+#include "MctsStrategy.h"
+#include "AllocationCounterHooks.h"
+
+// бенчмарки движка: шаги игры на лобби разного размера, время и выделения в куче на операцию.
+// состояние для замера готовится вне замера. Результаты печатаются по ходу и пишутся в JSON,
+// чтобы сравнивать их между версиями. Собирайте с -DCMAKE_BUILD_TYPE=Release
+
+struct BenchOptions {
+    int warmup = 1;
+    int repetitions = 5;
+    double budgetSeconds = 2.0;  // после этого повторы случая прекращаются, но хотя бы один будет
+    std::vector<int> sizes{5, 50, 1000, 100000, 1000000};
+    std::vector<int> gameSizes{5, 50, 1000};  // полная игра на 100 000 игроков идет часами
+    std::uint64_t seed = 1;
+    std::string jsonPath = "mafia_bench.json";
+};
+
+struct BenchResult {
+    std::string name;
+    int players = 0;
+    int repetitions = 0;
+    std::uint64_t operations = 0;
+    double nsPerOp = 0;
+    double allocationsPerOp = 0;
+    double nsPerPlayer = 0;  // у шагов с линейной сложностью почти не меняется с размером лобби
+};
+
+volatile std::uint64_t sink = 0;  // не дает компилятору выбросить работу
+
+// setup готовит состояние вне замера, run делает замеряемую работу и возвращает, сколько операций в ней было
+template <typename Setup, typename Run>
+BenchResult measure(const std::string& name, int players, const BenchOptions& options, Setup setup, Run run) {
+    using clock = std::chrono::steady_clock;
+    auto budgetEnd = clock::now() + std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(options.budgetSeconds));
+
+    for (int i = 0; i < options.warmup && clock::now() < budgetEnd; ++i) {
+        auto context = setup();
+        run(*context);
+    }
+
+    BenchResult result{name, players};
+    double totalNs = 0;
+    std::uint64_t totalAllocations = 0;
+    while (result.repetitions < std::max(1, options.repetitions) && (result.repetitions == 0 || clock::now() < budgetEnd)) {
+        auto context = setup();
+        std::uint64_t allocationsBefore = AllocationCounter::count();
+        auto start = clock::now();
+        result.operations += run(*context);
+        totalNs += std::chrono::duration<double, std::nano>(clock::now() - start).count();
+        totalAllocations += AllocationCounter::count() - allocationsBefore;
+        ++result.repetitions;
+    }
+
+    result.nsPerOp = totalNs / result.operations;
+    result.allocationsPerOp = static_cast<double>(totalAllocations) / result.operations;
+    result.nsPerPlayer = players > 0 ? result.nsPerOp / players : 0;
+    std::cout << std::fixed << std::setprecision(2) << std::setw(14) << result.nsPerOp << " нс/оп" << std::setw(12)
+              << result.allocationsPerOp << " выд/оп" << std::setw(12) << result.nsPerPlayer << " нс/игрока  " << name << " ["
+              << players << "]" << std::endl;
+    return result;
+}
+
+// игра ботов без вывода. Игра уничтожается раньше арены, в которой живут ее игроки
+struct BenchGame {
+    GameArena arena;
+    std::optional<GameMaster> game;
+
+    void start(int numPlayers, const std::vector<std::string>& names, std::uint64_t seed) {
+        game.emplace(arena, numPlayers, false, names, seed, true);
+    }
+};
+
+// самое большое лобби для замера MCTS
+constexpr int MaxMctsPlayers = 1000;
+
+// игра после первого дня и ночи и второго дня; снимок ниже берется перед второй ночью
+constexpr int SnapshotPhase = 3;
+
+// снимок посреди игры и место, куда из него восстанавливать продолжение
+struct BenchFork {
+    GameSnapshot snapshot;
+    GameArena arena;
+    std::optional<GameMaster> game;
+    std::string encoded;
+};
+
+// живые мирные боты, у каждого свой генератор, как в игре
+struct BenchLobby {
+    std::vector<MySharedPtr<Player>> players;
+    SplitMix64 rng;
+
+    BenchLobby(const std::vector<std::string>& names, int numPlayers, std::uint64_t seed) : rng(seed) {
+        players.reserve(numPlayers);
+        for (int id = 0; id < numPlayers; ++id) {
+            players.push_back(createPlayer(Role::Civilian, id, names[id], make_my_shared<BotStrategy>(SplitMix64::streamSeed(seed, id)),
+                                           std::pmr::get_default_resource()));
+        }
+    }
+};
+
+std::vector<BenchResult> runBenchmarks(const BenchOptions& options) {
+    int maxPlayers = 0;
+    for (int n : options.sizes) maxPlayers = std::max(maxPlayers, n);
+    for (int n : options.gameSizes) maxPlayers = std::max(maxPlayers, n);
+    // имена генерируются, в names.txt их меньше, чем игроков в больших лобби
+    const std::vector<std::string> names = generateNames(maxPlayers);
+    std::vector<BenchResult> results;
+
+    for (int n : options.sizes) {
+        auto emptyGame = [] { return std::make_unique<BenchGame>(); };
+        auto startedGame = [&] {
+            auto context = std::make_unique<BenchGame>();
+            context->start(n, names, options.seed);
+            return context;
+        };
+
+        // раздача ролей идет в конструкторе GameMaster, поэтому замеряется создание игры целиком
+        results.push_back(measure("assignRoles", n, options, emptyGame, [&](BenchGame& context) -> std::uint64_t {
+            context.start(n, names, options.seed);
+            return 1;
+        }));
+
+        results.push_back(measure("playDayPhase", n, options, startedGame, [](BenchGame& context) -> std::uint64_t {
+            context.game->playDayPhase();
+            return 1;
+        }));
+
+        results.push_back(measure("playNightPhase", n, options, startedGame, [](BenchGame& context) -> std::uint64_t {
+            context.game->playNightPhase();
+            return 1;
+        }));
+
+        results.push_back(measure("isGameOver", n, options, startedGame, [](BenchGame& context) -> std::uint64_t {
+            constexpr int calls = 10000;
+            for (int i = 0; i < calls; ++i) {
+                sink = sink + context.game->isGameOver();
+            }
+            return calls;
+        }));
+
+        // выбор цели бота: случайные попытки, проход по всем игрокам только если они не нашли цель
+        auto lobby = [&] { return std::make_unique<BenchLobby>(names, n, options.seed); };
+        results.push_back(measure("BotStrategy::pickTarget", n, options, lobby, [](BenchLobby& context) -> std::uint64_t {
+            constexpr int picks = 100000;
+            auto isAlive = [](const Player& player) { return player.isAlive(); };
+            for (int i = 0; i < picks; ++i) {
+                sink = sink + BotStrategy::pickTarget(context.players, isAlive, context.rng)->getId();
+            }
+            return picks;
+        }));
+    }
+
+    // решение MCTS с бюджетом в доигрываниях; операция — одно доигрывание, так что 1e9 / нс/оп — доигрываний в секунду.
+    // доигрывание идет до конца игры, поэтому на больших лобби не замеряется
+    for (int n : options.sizes) {
+        if (n > MaxMctsPlayers) {
+            continue;
+        }
+        auto startedGame = [&] {
+            auto context = std::make_unique<BenchGame>();
+            context->start(n, names, options.seed);
+            return context;
+        };
+        results.push_back(measure("MctsStrategy::vote", n, options, startedGame, [&](BenchGame& context) -> std::uint64_t {
+            MctsStrategy strategy(0, options.seed);
+            const auto& players = context.game->getPlayers();
+            auto notSelf = [](const Player& player) { return player.isAlive() && player.getId() != 0; };
+            std::uint64_t before = MctsStrategy::throughput().rollouts.load();
+            sink = sink + cppcoro::sync_wait(strategy.vote(players, notSelf));
+            return MctsStrategy::throughput().rollouts.load() - before;
+        }));
+    }
+
+    // логгер от числа игроков не зависит: строка голоса дописывается в буфер дня, и раз в 1000 строк
+    // буфер уходит в очередь фонового писателя. Выключенный лог только проверяет уровень
+    const std::string voter = "Игрок1", target = "Игрок2";
+    for (bool enabled : {false, true}) {
+        auto logger = [enabled] { return std::make_unique<Logger>(enabled); };
+        results.push_back(measure(enabled ? "Logger::add" : "Logger::add(disabled)", 0, options, logger,
+                                  [&](Logger& context) -> std::uint64_t {
+                                      constexpr int calls = 1000;
+                                      for (int i = 0; i < calls; ++i) {
+                                          context.add(LogSink::Day, LogLevel::Detail, "Игрок ", voter, " голосует за ", target, ".\n");
+                                      }
+                                      context.commit(LogSink::Day, 0);
+                                      return calls;
+                                  }));
+    }
+
+    for (int n : options.gameSizes) {
+        std::uint64_t gameSeed = options.seed;
+        auto startedGame = [&] {
+            auto context = std::make_unique<BenchGame>();
+            context->start(n, names, gameSeed++);  // каждый повтор — новая игра
+            return context;
+        };
+        results.push_back(measure("runGame", n, options, startedGame, [](BenchGame& context) -> std::uint64_t {
+            context.game->runGame();
+            return 1;
+        }));
+
+        // снимок после фазы, когда прошлый снимок уже был: неизменные записи игроков переиспользуются
+        auto midGame = [&] {
+            auto context = std::make_unique<BenchGame>();
+            context->start(n, names, options.seed);
+            for (int phase = 0; phase + 1 < SnapshotPhase; ++phase) {
+                context->game->playNextPhase();
+            }
+            context->game->snapshot();
+            context->game->playNextPhase();
+            return context;
+        };
+        results.push_back(measure("GameMaster::snapshot", n, options, midGame, [](BenchGame& context) -> std::uint64_t {
+            sink = sink + context.game->snapshot().players.size();
+            return 1;
+        }));
+
+        auto fork = [&] {
+            auto context = std::make_unique<BenchFork>();
+            BenchGame source;
+            source.start(n, names, options.seed);
+            for (int phase = 0; phase < SnapshotPhase; ++phase) {
+                source.game->playNextPhase();
+            }
+            context->snapshot = source.game->snapshot();
+            context->encoded = encodeSnapshot(context->snapshot);
+            return context;
+        };
+        results.push_back(measure("GameSnapshot copy", n, options, fork, [](BenchFork& context) -> std::uint64_t {
+            constexpr int copies = 100;
+            for (int i = 0; i < copies; ++i) {
+                GameSnapshot copy = context.snapshot;
+                sink = sink + copy.players.size();
+            }
+            return copies;
+        }));
+        results.push_back(measure("encodeSnapshot", n, options, fork, [](BenchFork& context) -> std::uint64_t {
+            sink = sink + encodeSnapshot(context.snapshot).size();
+            return 1;
+        }));
+        results.push_back(measure("decodeSnapshot", n, options, fork, [](BenchFork& context) -> std::uint64_t {
+            GameSnapshot decoded;
+            sink = sink + decodeSnapshot(context.encoded, decoded);
+            return 1;
+        }));
+
+        // продолжение со снимка с новым сидом — то, что делает анализ «а что если»
+        std::uint64_t forkSeed = options.seed;
+        results.push_back(measure("forkFromSnapshot", n, options, fork, [&](BenchFork& context) -> std::uint64_t {
+            context.game.emplace(context.arena, context.snapshot, true);
+            context.game->reseed(++forkSeed);
+            context.game->runGame();
+            return 1;
+        }));
+    }
+
+    return results;
+}
+
+// игра, восстановленная из закодированного снимка, должна закончиться так же, как исходная
+bool restoredGameMatches(int numPlayers, std::uint64_t seed) {
+    const std::vector<std::string> names = generateNames(numPlayers);
+    BenchGame original;
+    original.start(numPlayers, names, seed);
+    for (int phase = 0; phase < SnapshotPhase; ++phase) {
+        original.game->playNextPhase();
+    }
+
+    GameSnapshot decoded;
+    if (!decodeSnapshot(encodeSnapshot(original.game->snapshot()), decoded)) {
+        return false;
+    }
+    BenchGame restored;
+    restored.game.emplace(restored.arena, decoded, true);
+
+    original.game->runGame();
+    restored.game->runGame();
+    return encodeSnapshot(original.game->snapshot()) == encodeSnapshot(restored.game->snapshot());
+}
+
+void writeJson(const std::string& path, const BenchOptions& options, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"benchmark\": \"MafiaBench\",\n";
+    out << "  \"seed\": " << options.seed << ",\n";
+    out << "  \"warmup\": " << options.warmup << ",\n";
+    out << "  \"repetitions\": " << options.repetitions << ",\n";
+#ifdef __AVX2__
+    out << "  \"avx2\": true,\n";
+#else
+    out << "  \"avx2\": false,\n";
+#endif
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"players\": " << r.players << ", \"repetitions\": " << r.repetitions
+            << ", \"operations\": " << r.operations << ", \"ns_per_op\": " << r.nsPerOp
+            << ", \"allocs_per_op\": " << r.allocationsPerOp << ", \"ns_per_player\": " << r.nsPerPlayer << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+std::vector<int> parseSizes(const std::string& list) {
+    std::vector<int> sizes;
+    std::stringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            sizes.push_back(std::stoi(item));
+        }
+    }
+    return sizes;
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Не указано значение для " << arg << ".\n";
+            return 1;
+        }
+        if (arg == "--sizes") {
+            options.sizes = parseSizes(argv[++i]);
+        } else if (arg == "--game-sizes") {
+            options.gameSizes = parseSizes(argv[++i]);
+        } else if (arg == "--warmup") {
+            options.warmup = std::stoi(argv[++i]);
+        } else if (arg == "--repetitions") {
+            options.repetitions = std::stoi(argv[++i]);
+        } else if (arg == "--budget-seconds") {
+            options.budgetSeconds = std::stod(argv[++i]);
+        } else if (arg == "--seed") {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--json") {
+            options.jsonPath = argv[++i];
+        } else {
+            std::cerr << "Неизвестный параметр: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    auto validLobby = [](int n) { return n >= 5; };
+    if (!std::all_of(options.sizes.begin(), options.sizes.end(), validLobby) ||
+        !std::all_of(options.gameSizes.begin(), options.gameSizes.end(), validLobby)) {
+        std::cerr << "В лобби нужно хотя бы 5 игроков.\n";
+        return 1;
+    }
+
+    for (int n : options.gameSizes) {
+        if (!restoredGameMatches(n, options.seed)) {
+            std::cerr << "Игра со снимка разошлась с исходной (" << n << " игроков).\n";
+            return 1;
+        }
+    }
+
+    std::vector<BenchResult> results = runBenchmarks(options);
+    writeJson(options.jsonPath, options, results);
+    std::cout << "Результаты записаны в " << options.jsonPath << "\n";
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+#include "MySharedPtr.h"
+
+// сравнение MySharedPtr и std::shared_ptr на тех операциях, которые делает игра:
+// создание игроков, копирование в списки живых и перемещение при росте вектора.
+// в конце — нагрузочная проверка атомарного счетчика из многих потоков
+
+struct Payload {
+    virtual ~Payload() = default;
+    int id = 0;
+    std::string name = "player";
+};
+
+struct DerivedPayload : Payload {
+    explicit DerivedPayload(int id) { this->id = id; }
+};
+
+volatile long long sink = 0;  // не дает компилятору выбросить работу
+
+template <typename Fn>
+void measure(const char* name, int ops, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::fixed << std::setprecision(2) << std::setw(10) << elapsed / ops << " нс/оп  " << name << "\n";
+}
+
+template <typename Ptr, typename Make>
+void runSuite(const char* title, int n, Make make) {
+    std::cout << title << ":\n";
+
+    measure("создание/удаление", n, [&] {
+        for (int i = 0; i < n; ++i) {
+            Ptr p = make(i);
+            sink = sink + p->id;
+        }
+    });
+
+    std::vector<Ptr> source;
+    source.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        source.push_back(make(i));
+    }
+
+    measure("копирование", n, [&] {
+        std::vector<Ptr> copies;
+        copies.reserve(n);
+        for (const auto& p : source) {
+            copies.push_back(p);
+        }
+        sink = sink + copies.back()->id;
+    });
+
+    measure("перемещение в вектор", n, [&] {
+        std::vector<Ptr> moved;  // без reserve: при росте элементы перемещаются
+        for (auto& p : source) {
+            moved.push_back(std::move(p));
+        }
+        sink = sink + moved.back()->id;
+        source = std::move(moved);
+    });
+
+    measure("пустой указатель", n, [&] {
+        for (int i = 0; i < n; ++i) {
+            Ptr p;
+            sink = sink + static_cast<bool>(p);
+        }
+    });
+}
+
+std::atomic<long long> trackedDestroyed{0};
+
+struct TrackedPayload : Payload {
+    ~TrackedPayload() override { trackedDestroyed.fetch_add(1, std::memory_order_relaxed); }
+};
+
+// потоки одновременно копируют, перемещают и уничтожают общие указатели;
+// каждый объект должен быть удален ровно один раз и только после последней ссылки
+bool stressAtomicCounting(int numThreads, int numObjects, int rounds) {
+    trackedDestroyed = 0;
+    std::vector<MyAtomicSharedPtr<Payload>> shared;
+    for (int i = 0; i < numObjects; ++i) {
+        shared.push_back(make_my_atomic_shared<TrackedPayload>());
+    }
+
+    std::atomic<bool> start{false};
+    std::atomic<bool> finish{false};
+    std::atomic<int> holding{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&, t] {
+            while (!start.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            std::vector<MyAtomicSharedPtr<Payload>> local;
+            for (int r = 0; r < rounds; ++r) {
+                for (int i = 0; i < numObjects; ++i) {
+                    MyAtomicSharedPtr<Payload> copy = shared[(i + t) % numObjects];
+                    local.push_back(std::move(copy));
+                }
+                local.clear();
+            }
+            // последние ссылки потоков переживают ссылки главного потока
+            local = shared;
+            holding.fetch_add(1, std::memory_order_release);
+            while (!finish.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    while (holding.load(std::memory_order_acquire) != numThreads) {
+        std::this_thread::yield();
+    }
+    shared.clear();
+    bool ok = trackedDestroyed.load() == 0;  // иначе объект удален, пока на него ссылались потоки
+    finish.store(true, std::memory_order_release);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return ok && trackedDestroyed.load() == numObjects;
+}
+
+int main(int argc, char* argv[]) {
+    int n = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    if (n <= 0) {
+        std::cerr << "Число операций должно быть положительным.\n";
+        return 1;
+    }
+
+    runSuite<MySharedPtr<Payload>>("MySharedPtr (make_my_shared)", n, [](int i) {
+        return MySharedPtr<Payload>(make_my_shared<DerivedPayload>(i));
+    });
+    runSuite<MySharedPtr<Payload>>("MySharedPtr (new)", n, [](int i) {
+        return MySharedPtr<Payload>(new DerivedPayload(i));
+    });
+    runSuite<std::shared_ptr<Payload>>("std::shared_ptr (make_shared)", n, [](int i) {
+        return std::shared_ptr<Payload>(std::make_shared<DerivedPayload>(i));
+    });
+    runSuite<MyAtomicSharedPtr<Payload>>("MyAtomicSharedPtr (make_my_atomic_shared)", n, [](int i) {
+        return MyAtomicSharedPtr<Payload>(make_my_atomic_shared<DerivedPayload>(i));
+    });
+
+    int numThreads = std::max(2u, std::thread::hardware_concurrency());
+    auto start = std::chrono::steady_clock::now();
+    bool ok = stressAtomicCounting(numThreads, 64, std::max(1, n / 64));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Нагрузочная проверка атомарного счетчика (" << numThreads << " потоков, " << seconds << " с): "
+              << (ok ? "ок" : "ОШИБКА") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+// считает выделения памяти в куче отдельно в каждом потоке.
+// счетчик растет, только если в программу подключен AllocationCounterHooks.h (MafiaBench всегда, MafiaGame —
+// с MAFIA_ENABLE_ALLOCATION_COUNTER), иначе он всегда 0
+class AllocationCounter {
+public:
+    static std::uint64_t count() { return allocations; }
+    static void onAllocate() { ++allocations; }
+
+private:
+    static inline thread_local std::uint64_t allocations = 0;
+};
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,139 @@
+#ifndef ALLOCATIONCOUNTERHOOKS_H
+#define ALLOCATIONCOUNTERHOOKS_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include "AllocationCounter.h"
+
+// глобальные operator new/delete, которые считают выделения в AllocationCounter.
+// замены определяются прямо здесь, поэтому заголовок подключается только в одну
+// единицу трансляции программы — ту, где main.
+// заменено все семейство: обычные, массивы, с выравниванием и nothrow, иначе часть
+// выделений шла бы мимо счетчика, а память из одной пары освобождалась бы другой.
+// все удаления сходятся в free: и malloc, и aligned_alloc освобождаются через него
+
+namespace allocation_counter_hooks {
+
+inline void* allocate(std::size_t size) {
+    AllocationCounter::onAllocate();
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+inline void* allocate(std::size_t size, std::align_val_t alignment) {
+    AllocationCounter::onAllocate();
+    const auto align = static_cast<std::size_t>(alignment);
+    // aligned_alloc требует размер, кратный выравниванию
+    const std::size_t rounded = (size + align - 1) / align * align;
+    if (void* p = std::aligned_alloc(align, rounded ? rounded : align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+inline void release(void* p) noexcept {
+    std::free(p);
+}
+
+} // namespace allocation_counter_hooks
+
+void* operator new(std::size_t size) {
+    return allocation_counter_hooks::allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return allocation_counter_hooks::allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocation_counter_hooks::allocate(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return allocation_counter_hooks::allocate(size, alignment);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocation_counter_hooks::allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocation_counter_hooks::allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return allocation_counter_hooks::allocate(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    try {
+        return allocation_counter_hooks::allocate(size, alignment);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete[](void* p) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    allocation_counter_hooks::release(p);
+}
+
+#endif // ALLOCATIONCOUNTERHOOKS_H
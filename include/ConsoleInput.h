@@ -0,0 +1,149 @@
+#ifndef CONSOLEINPUT_H
+#define CONSOLEINPUT_H
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+struct ConsoleInputOptions {
+    std::chrono::milliseconds turnTimeout{0};  // время на ход человека, 0 — без ограничения
+};
+
+// асинхронное чтение строк из stdin. Отдельный поток читает строки, а корутина,
+// которая ждет ввода, приостанавливается и продолжается на потоке чтения, когда строка пришла,
+// или на потоке таймера, когда вышел срок. Пока человек думает, поток игры занят другими игроками.
+// ждать ввод может только одна корутина за раз — человек в игре один
+class ConsoleInput {
+public:
+    using Options = ConsoleInputOptions;
+    using Clock = std::chrono::steady_clock;
+
+    class LineAwaiter {
+    public:
+        LineAwaiter(ConsoleInput& input, Clock::time_point deadline) : input(input), deadline(deadline) {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> h) { return input.suspendUntilLine(*this, h); }
+        // nullopt — срок вышел или stdin закрыт
+        std::optional<std::string> await_resume() { return std::move(line); }
+
+    private:
+        friend class ConsoleInput;
+        ConsoleInput& input;
+        Clock::time_point deadline;
+        std::optional<std::string> line;
+        std::coroutine_handle<> handle;
+    };
+
+    // общий читатель процесса. Поток чтения нельзя прервать посреди getline, поэтому объект
+    // намеренно не уничтожается, а потоки отсоединены. До первого обращения stdin можно читать напрямую
+    static ConsoleInput& shared() {
+        static ConsoleInput* input = new ConsoleInput();
+        return *input;
+    }
+
+    static Options& sharedOptions() {
+        static Options options;
+        return options;
+    }
+
+    LineAwaiter readLine(Clock::time_point deadline = Clock::time_point::max()) {
+        return LineAwaiter(*this, deadline);
+    }
+
+    // строки, набранные до приглашения к ходу, к этому ходу не относятся
+    void discardPending() {
+        std::lock_guard lock(mutex);
+        lines.clear();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::string> lines;
+    bool closed = false;
+    LineAwaiter* waiting = nullptr;
+    std::uint64_t generation = 0;  // номер ожидания, чтобы таймер не спутал новое ожидание со старым
+
+    ConsoleInput() {
+        std::thread([this] { readLoop(); }).detach();
+        std::thread([this] { timerLoop(); }).detach();
+    }
+
+    // false — строка (или отказ) уже есть, корутина продолжается без приостановки
+    bool suspendUntilLine(LineAwaiter& awaiter, std::coroutine_handle<> h) {
+        std::lock_guard lock(mutex);
+        if (!lines.empty()) {
+            awaiter.line = std::move(lines.front());
+            lines.pop_front();
+            return false;
+        }
+        if (closed || awaiter.deadline <= Clock::now()) {
+            return false;
+        }
+        awaiter.handle = h;
+        waiting = &awaiter;
+        ++generation;
+        changed.notify_all();
+        return true;
+    }
+
+    void readLoop() {
+        std::string text;
+        while (std::getline(std::cin, text)) {
+            std::unique_lock lock(mutex);
+            if (LineAwaiter* awaiter = waiting) {
+                waiting = nullptr;
+                awaiter->line = std::move(text);
+                lock.unlock();
+                changed.notify_all();
+                awaiter->handle.resume();
+            } else {
+                lines.push_back(std::move(text));
+            }
+        }
+
+        std::unique_lock lock(mutex);
+        closed = true;
+        LineAwaiter* awaiter = std::exchange(waiting, nullptr);
+        lock.unlock();
+        changed.notify_all();
+        if (awaiter) {
+            awaiter->handle.resume();
+        }
+    }
+
+    void timerLoop() {
+        std::unique_lock lock(mutex);
+        for (;;) {
+            changed.wait(lock, [&] { return waiting != nullptr; });
+            // пока мы ждем без блокировки, ожидание могут завершить и кадр корутины освободить,
+            // поэтому срок копируем, а к awaiter обращаемся только под блокировкой и только если он еще наш
+            std::uint64_t turn = generation;
+            Clock::time_point deadline = waiting->deadline;
+            auto answeredOrReplaced = [&] { return waiting == nullptr || generation != turn; };
+
+            if (deadline == Clock::time_point::max()) {
+                changed.wait(lock, answeredOrReplaced);
+                continue;
+            }
+            if (changed.wait_until(lock, deadline, answeredOrReplaced)) {
+                continue;
+            }
+            LineAwaiter* awaiter = std::exchange(waiting, nullptr);
+            lock.unlock();
+            awaiter->handle.resume();
+            lock.lock();
+        }
+    }
+};
+
+#endif // CONSOLEINPUT_H
@@ -0,0 +1,81 @@
+#ifndef CONSOLERENDERER_H
+#define CONSOLERENDERER_H
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include "TextFormat.h"
+
+// сколько игра пишет в консоль. Silent — ничего, Summary — заголовки фаз и итоги (казни, ночь, победа),
+// Full — еще каждый голос, подсчет голосов и список игроков
+enum class Verbosity : std::uint8_t {
+    Silent,
+    Summary,
+    Full
+};
+
+// false, если такого уровня нет
+constexpr bool verbosityFromKey(std::string_view key, Verbosity& verbosity) {
+    constexpr std::string_view keys[] = {"silent", "summary", "full"};
+    for (size_t i = 0; i < std::size(keys); ++i) {
+        if (key == keys[i]) {
+            verbosity = static_cast<Verbosity>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+struct ConsoleRendererOptions {
+    Verbosity verbosity = Verbosity::Full;
+};
+
+// вывод игры в консоль. Текст собирается в буфер, который не освобождается между фазами,
+// и уходит в поток одной записью на flush. Если уровень строки отбрасывается, print ничего не форматирует;
+// циклы по игрокам стоит оборачивать в shows, чтобы не тратить и обход
+class ConsoleRenderer {
+public:
+    using Options = ConsoleRendererOptions;
+
+    static Options& sharedOptions() {
+        static Options options;
+        return options;
+    }
+
+    explicit ConsoleRenderer(Verbosity verbosity, std::ostream& out = std::cout) : verbosity(verbosity), out(out) {}
+
+    ConsoleRenderer(const ConsoleRenderer&) = delete;
+    ConsoleRenderer& operator=(const ConsoleRenderer&) = delete;
+
+    ~ConsoleRenderer() { flush(); }
+
+    bool shows(Verbosity level) const {
+        return verbosity != Verbosity::Silent && level <= verbosity;
+    }
+
+    // части — строки, символы и целые, см. appendParts
+    template <typename... Parts>
+    void print(Verbosity level, const Parts&... parts) {
+        if (!shows(level)) {
+            return;
+        }
+        appendParts(buffer, parts...);
+    }
+
+    void flush() {
+        if (buffer.empty()) {
+            return;
+        }
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        out.flush();
+        buffer.clear();
+    }
+
+private:
+    Verbosity verbosity;
+    std::ostream& out;
+    std::string buffer;
+};
+
+#endif // CONSOLERENDERER_H
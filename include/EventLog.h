@@ -0,0 +1,138 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Roles.h"
+
+// бинарный журнал событий: на каждую игру заголовок и массив записей фиксированного размера.
+// игры в файле идут подряд, так что файл можно дописывать из многих потоков целыми блоками
+
+constexpr std::uint32_t EventLogMagic = 0x3146414D;  // "MAF1"
+constexpr std::uint16_t EventLogVersion = 2;  // 2: день — uint32, запись 20 байт
+constexpr std::uint32_t NoEventPlayer = 0xFFFFFFFF;
+
+enum class EventPhase : std::uint8_t {
+    Setup,
+    Day,
+    Night,
+    End
+};
+
+enum class EventAction : std::uint8_t {
+    AssignRole,  // outcome — Role
+    Vote,        // дневной голос
+    Execute,     // казнь днем, outcome — число голосов
+    MafiaVote,   // голос мафиози за ночную жертву
+    Kill,        // ночное убийство, outcome — 1 если игрок погиб
+    Heal,        // лечение доктора, outcome — 1 если он кого-то спас
+    Check,       // проверка комиссара, outcome — 1 если мафия
+    GameOver     // outcome — победившая сторона
+};
+
+// совпадает с порядком Winner в игре
+enum class EventWinner : std::uint8_t {
+    None,
+    Mafia,
+    Civilians,
+    Maniac
+};
+
+struct EventLogGameHeader {
+    std::uint32_t magic;
+    std::uint16_t version;
+    std::uint16_t recordSize;
+    std::uint64_t seed;
+    std::uint32_t numPlayers;
+    std::uint32_t numEvents;
+};
+
+// игра на n игроков идет порядка n дней, а лобби бывают до миллиона игроков, так что день — 32 бита
+struct EventRecord {
+    std::uint32_t day;
+    EventPhase phase;
+    EventAction action;
+    std::uint16_t reserved;  // явное выравнивание, чтобы в файл не попадал мусор из отступа
+    std::uint32_t actor;
+    std::uint32_t target;
+    std::uint32_t outcome;
+};
+
+static_assert(sizeof(EventLogGameHeader) == 24, "заголовок игры должен занимать 24 байта");
+static_assert(sizeof(EventRecord) == 20, "запись журнала должна занимать 20 байт");
+
+// собирает события одной игры и кодирует их одним блоком
+class EventLogBuffer {
+public:
+    void record(int day, EventPhase phase, EventAction action, std::uint32_t actor, std::uint32_t target, std::uint32_t outcome = 0) {
+        events.push_back(EventRecord{static_cast<std::uint32_t>(day), phase, action, 0, actor, target, outcome});
+    }
+
+    std::string encode(std::uint64_t seed, std::uint32_t numPlayers) const {
+        EventLogGameHeader header{EventLogMagic, EventLogVersion, sizeof(EventRecord), seed, numPlayers,
+                                  static_cast<std::uint32_t>(events.size())};
+        std::string block(sizeof(header) + events.size() * sizeof(EventRecord), '\0');
+        std::memcpy(block.data(), &header, sizeof(header));
+        if (!events.empty()) {
+            std::memcpy(block.data() + sizeof(header), events.data(), events.size() * sizeof(EventRecord));
+        }
+        return block;
+    }
+
+    void clear() { events.clear(); }
+    bool empty() const { return events.empty(); }
+
+    // записи игры до сих пор, для снимков
+    const std::vector<EventRecord>& records() const { return events; }
+    void assign(std::vector<EventRecord> records) { events = std::move(records); }
+
+private:
+    std::vector<EventRecord> events;
+};
+
+// последовательный обход игр в уже загруженном (например, отображенном в память) журнале.
+// блок игры занимает 24 + 20n байт, так что заголовок после игры с нечетным числом событий
+// лежит не на границе 8 байт: его копируем, а записи (выравнивание 4) читаем на месте
+class EventLogCursor {
+public:
+    struct Game {
+        EventLogGameHeader header;
+        const EventRecord* events;
+    };
+
+    EventLogCursor(const void* data, size_t size)
+        : pos(static_cast<const unsigned char*>(data)), end(pos + size) {}
+
+    // false — журнал закончился или поврежден (см. isCorrupted)
+    bool next(Game& game) {
+        if (static_cast<size_t>(end - pos) < sizeof(EventLogGameHeader)) {
+            corrupted = pos != end;
+            return false;
+        }
+        EventLogGameHeader header;
+        std::memcpy(&header, pos, sizeof(header));
+        size_t eventsSize = static_cast<size_t>(header.numEvents) * sizeof(EventRecord);
+        if (header.magic != EventLogMagic || header.version != EventLogVersion ||
+            header.recordSize != sizeof(EventRecord) ||
+            static_cast<size_t>(end - pos) - sizeof(EventLogGameHeader) < eventsSize) {
+            corrupted = true;
+            return false;
+        }
+        game.header = header;
+        game.events = reinterpret_cast<const EventRecord*>(pos + sizeof(EventLogGameHeader));
+        pos += sizeof(EventLogGameHeader) + eventsSize;
+        return true;
+    }
+
+    bool isCorrupted() const { return corrupted; }
+
+private:
+    const unsigned char* pos;
+    const unsigned char* end;
+    bool corrupted = false;
+};
+
+#endif // EVENTLOG_H
@@ -0,0 +1,52 @@
+#ifndef FUNCTIONREF_H
+#define FUNCTIONREF_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature>
+class FunctionRef;
+
+// невладеющая ссылка на вызываемый объект: указатель на объект и указатель на функцию-переходник.
+// в отличие от std::function ничего не копирует и не выделяет, зато объект должен пережить ссылку.
+// если ссылка уходит в ленивую корутину, лямбда вызывающего к ее запуску уже уничтожена,
+// поэтому там удобнее bind<&Class::method>(object) — объект живет дольше корутины
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <typename F>
+        requires(!std::is_same_v<std::remove_cvref_t<F>, FunctionRef> && std::is_invocable_r_v<R, F&, Args...>)
+    FunctionRef(F&& f) noexcept
+        : object(const_cast<void*>(static_cast<const void*>(std::addressof(f)))),
+          invoke([](void* o, Args... args) -> R {
+              return std::invoke(*static_cast<std::remove_reference_t<F>*>(o), std::forward<Args>(args)...);
+          }) {}
+
+    // пустая ссылка, проверяется через operator bool; вызывать ее нельзя
+    FunctionRef(std::nullptr_t) noexcept : object(nullptr), invoke(nullptr) {}
+
+    // константный метод объекта: ссылка ведет на сам объект, лямбда-обертка не нужна
+    template <auto Method, typename Object>
+    static FunctionRef bind(const Object* target) noexcept {
+        return FunctionRef(const_cast<Object*>(target), [](void* o, Args... args) -> R {
+            return std::invoke(Method, static_cast<const Object*>(o), std::forward<Args>(args)...);
+        });
+    }
+
+    R operator()(Args... args) const {
+        return invoke(object, std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept { return invoke != nullptr; }
+
+private:
+    void* object;
+    R (*invoke)(void*, Args...);
+
+    FunctionRef(void* object, R (*invoke)(void*, Args...)) noexcept : object(object), invoke(invoke) {}
+};
+
+#endif // FUNCTIONREF_H
@@ -0,0 +1,1569 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <fstream>
+#include <cstdint>
+#include <cassert>
+#include <string_view>
+#include <latch>
+#include <optional>
+#include <exception>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <cppcoro/task.hpp>
+#include <cppcoro/when_all.hpp>
+#include <cppcoro/sync_wait.hpp>
+#include <cppcoro/static_thread_pool.hpp>
+#include "MySharedPtr.h"
+#include "Logger.h"
+#include "EventLog.h"
+#include "Roles.h"
+#include "GameArena.h"
+#include "FunctionRef.h"
+#include "GameState.h"
+#include "ConsoleInput.h"
+#include "ConsoleRenderer.h"
+#include "AllocationCounter.h"
+#include "Metrics.h"
+#include "GameSnapshot.h"
+
+// игровой движок: игроки, стратегии и GameMaster. Его используют MafiaGame и бенчмарки
+
+class Player;
+class PlayerStrategy;
+
+// игроки нумеруются подряд с нуля, id совпадает с индексом в GameMaster::players
+using PlayerId = int;
+constexpr PlayerId NoPlayer = -1;
+
+// генератор бота: 8 байт состояния и свой поток чисел у каждого бота, поэтому боты
+// могут решать параллельно, а игра все равно повторяется по сиду
+class SplitMix64 {
+public:
+    using result_type = std::uint64_t;
+
+    explicit SplitMix64(std::uint64_t seed) : state(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return ~result_type{0}; }
+
+    result_type operator()() {
+        return mix(state += 0x9E3779B97F4A7C15ULL);
+    }
+
+    // состояние целиком: SplitMix64(getState()) продолжает тот же поток чисел
+    std::uint64_t getState() const { return state; }
+
+    // независимый сид для бота id в игре с сидом gameSeed
+    static std::uint64_t streamSeed(std::uint64_t gameSeed, std::uint64_t id) {
+        return mix(gameSeed ^ mix(id + 1));
+    }
+
+private:
+    std::uint64_t state;
+
+    static std::uint64_t mix(std::uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+};
+
+// ночное действие игрока: что и с кем. ActionKind::None или NoPlayer — ничего не делает
+struct NightAction {
+    ActionKind kind = ActionKind::None;
+    PlayerId target = NoPlayer;
+};
+
+// кому можно адресовать голос или ночное действие. Ссылка невладеющая: фильтры — методы игрока,
+// который переживает корутину решения (см. FunctionRef::bind)
+using TargetFilter = FunctionRef<bool(const Player&)>;
+
+class PlayerStrategy {
+public:
+    virtual ~PlayerStrategy() = default;
+
+    virtual cppcoro::task<PlayerId> vote(
+        const std::vector<MySharedPtr<Player>>& players,
+        TargetFilter targetFilter) = 0;
+
+    // availableActions — набор роли из RoleTraits::nightActions
+    virtual cppcoro::task<NightAction> chooseAction(
+        const std::vector<MySharedPtr<Player>>& players, 
+        std::span<const ActionKind> availableActions,
+        TargetFilter targetFilter) = 0;
+
+    // состояние генератора стратегии, для снимков игры
+    virtual std::uint64_t randomState() const = 0;
+    virtual void setRandomState(std::uint64_t state) = 0;
+};
+
+class Player {
+public:
+    Player(PlayerId id, Role role, const std::string& name, MySharedPtr<PlayerStrategy> strategy) 
+        : id(id), role(role), playerName(name), alive(true), strategy(std::move(strategy)) {}
+
+    virtual ~Player() = default;
+
+    virtual cppcoro::task<PlayerId> vote(const std::vector<MySharedPtr<Player>>& players) {        
+        return strategy->vote(players, TargetFilter::bind<&Player::isOther>(this));
+    }
+
+    virtual cppcoro::task<NightAction> nightAction(
+        const std::vector<MySharedPtr<Player>>& players) = 0;
+
+    PlayerId getId() const { return id; }
+    Role getRole() const { return role; }
+    Faction getFaction() const { return roleTraits(role).faction; }
+    const std::string& getName() const { return playerName; }
+    bool isAlive() const { return alive; }
+    DeathReveal getDeathReveal() const { return deathReveal; }
+    void die(DeathReveal reveal) {
+        alive = false;
+        deathReveal = reveal;
+    }
+    MySharedPtr<PlayerStrategy> getStrategy() const { return strategy; }
+
+    // то, что меняется по ходу игры; роли со своим состоянием дополняют
+    virtual void saveState(PlayerState& saved) const {
+        saved.alive = alive;
+        saved.deathReveal = deathReveal;
+    }
+    virtual void restoreState(const PlayerState& saved) {
+        alive = saved.alive;
+        deathReveal = saved.deathReveal;
+    }
+
+protected:
+    // живой и не мы сами: не голосуем против себя
+    bool isOther(const Player& player) const {
+        return player.isAlive() && &player != this;
+    }
+
+    PlayerId id;
+    Role role;  // задается при создании, по ней диспетчеризуются все проверки роли
+    // имя не копируется: оно лежит в списке имен игры, который переживает игроков (см. GameMaster)
+    const std::string& playerName;
+    bool alive;
+    DeathReveal deathReveal = DeathReveal::None;
+    MySharedPtr<PlayerStrategy> strategy;
+};
+
+class BotStrategy : public PlayerStrategy {
+public:
+    // сид выводится из сида игры и id бота, см. SplitMix64::streamSeed
+    explicit BotStrategy(std::uint64_t seed) : rng(seed) {}
+
+    cppcoro::task<PlayerId> vote(
+        const std::vector<MySharedPtr<Player>>& players,
+        TargetFilter targetFilter) override {
+        
+        Player* target = pickTarget(players, targetFilter, rng);
+        if (target) {
+            co_return target->getId();
+        }
+        
+        co_return NoPlayer;
+    }
+
+
+    cppcoro::task<NightAction> chooseAction(
+        const std::vector<MySharedPtr<Player>>& players, 
+        std::span<const ActionKind> availableActions,
+        TargetFilter targetFilter) override {
+        
+        Player* target = pickTarget(players, targetFilter, rng);
+        if (target && !availableActions.empty()) {
+            std::uniform_int_distribution<size_t> actionDistr(0, availableActions.size() - 1);
+            co_return NightAction{availableActions[actionDistr(rng)], target->getId()};
+        }
+        co_return NightAction{};
+    }
+
+    std::uint64_t randomState() const override { return rng.getState(); }
+    void setRandomState(std::uint64_t state) override { rng = SplitMix64(state); }
+
+    // сколько случайных игроков пробует pickTarget, прежде чем пройти по всем
+    static constexpr int SampleAttempts = 32;
+
+    // равновероятный подходящий игрок. Сначала пробуем случайных игроков: подходит обычно заметная
+    // доля, так что цель находится за несколько попыток, и фаза из n решений остается O(n), а не O(n^2).
+    // Если за SampleAttempts попыток не нашли, один проход с reservoir sampling: k-й подходящий заменяет
+    // выбранного с вероятностью 1/k. Оба способа равномерны, поэтому и вместе выбор равномерный.
+    // Без списка кандидатов и без копий MySharedPtr — решения могут идти на разных потоках,
+    // а счетчик ссылок игроков не атомарный
+    static Player* pickTarget(const std::vector<MySharedPtr<Player>>& players, TargetFilter targetFilter, SplitMix64& rng) {
+        if (players.empty()) {
+            return nullptr;
+        }
+        std::uniform_int_distribution<size_t> anyPlayer(0, players.size() - 1);
+        for (int attempt = 0; attempt < SampleAttempts; ++attempt) {
+            Player* candidate = players[anyPlayer(rng)].get();
+            if (targetFilter(*candidate)) {
+                return candidate;
+            }
+        }
+
+        Player* chosen = nullptr;
+        std::uint64_t seen = 0;
+        for (const auto& player : players) {
+            if (targetFilter(*player) && std::uniform_int_distribution<std::uint64_t>(0, seen++)(rng) == 0) {
+                chosen = player.get();
+            }
+        }
+        return chosen;
+    }
+
+private:
+    SplitMix64 rng;
+};
+
+// бот с обидой: голосует и действует против одного и того же игрока, пока тот подходит под фильтр,
+// потом выбирает новую цель так же, как BotStrategy. Простая стратегия, отличная от случайной, для турниров.
+// обида в снимок игры не попадает, со снимка все боты продолжают как BotStrategy
+class GrudgeBotStrategy : public PlayerStrategy {
+public:
+    explicit GrudgeBotStrategy(std::uint64_t seed) : rng(seed) {}
+
+    cppcoro::task<PlayerId> vote(
+        const std::vector<MySharedPtr<Player>>& players,
+        TargetFilter targetFilter) override {
+
+        Player* target = pickGrudge(players, targetFilter);
+        co_return target ? target->getId() : NoPlayer;
+    }
+
+    cppcoro::task<NightAction> chooseAction(
+        const std::vector<MySharedPtr<Player>>& players,
+        std::span<const ActionKind> availableActions,
+        TargetFilter targetFilter) override {
+
+        Player* target = pickGrudge(players, targetFilter);
+        if (target && !availableActions.empty()) {
+            std::uniform_int_distribution<size_t> actionDistr(0, availableActions.size() - 1);
+            co_return NightAction{availableActions[actionDistr(rng)], target->getId()};
+        }
+        co_return NightAction{};
+    }
+
+    std::uint64_t randomState() const override { return rng.getState(); }
+    void setRandomState(std::uint64_t state) override { rng = SplitMix64(state); }
+
+private:
+    SplitMix64 rng;
+    PlayerId grudge = NoPlayer;
+
+    Player* pickGrudge(const std::vector<MySharedPtr<Player>>& players, TargetFilter targetFilter) {
+        if (grudge != NoPlayer && static_cast<size_t>(grudge) < players.size() && targetFilter(*players[grudge])) {
+            return players[grudge].get();
+        }
+        Player* target = BotStrategy::pickTarget(players, targetFilter, rng);
+        grudge = target ? target->getId() : NoPlayer;
+        return target;
+    }
+};
+
+// ход человека. Ввод читается асинхронно (ConsoleInput), так что пока человек думает,
+// боты уже решают. Если за ConsoleInput::sharedOptions().turnTimeout ответа нет, ход делает запасной бот
+class UserStrategy : public PlayerStrategy {
+public:
+    explicit UserStrategy(std::uint64_t fallbackSeed) : fallback(fallbackSeed) {}
+
+    cppcoro::task<PlayerId> vote(
+        const std::vector<MySharedPtr<Player>>& players,
+        TargetFilter targetFilter) override {
+        
+        auto deadline = startTurn();
+        std::cout << "Введите имя игрока, за которого хотите проголосовать: " << std::flush;
+        std::optional<std::string> choice = co_await ConsoleInput::shared().readLine(deadline);
+        if (!choice) {
+            announceTimeout();
+            co_return co_await fallback.vote(players, targetFilter);
+        }
+
+        auto it = std::find_if(players.begin(), players.end(), [&](const MySharedPtr<Player>& player) {
+            return player->getName() == trimmed(*choice) && targetFilter(*player);
+        });
+
+        if (it != players.end()) {
+            co_return (*it)->getId();
+        }
+        co_return NoPlayer;
+    }
+
+    cppcoro::task<NightAction> chooseAction(
+        const std::vector<MySharedPtr<Player>>& players, 
+        std::span<const ActionKind> availableActions,
+        TargetFilter targetFilter) override {
+        
+        auto deadline = startTurn();
+        std::cout << "Введите имя игрока, с которым хотите совершить действие: " << std::flush;
+        std::optional<std::string> target = co_await ConsoleInput::shared().readLine(deadline);
+
+        std::optional<std::string> action;
+        if (target) {
+            std::cout << "Доступные действия:\n";
+            for (ActionKind kind : availableActions) {
+                std::cout << "- " << actionKey(kind) << "\n";
+            }
+            std::cout << "Введите действие: " << std::flush;
+            action = co_await ConsoleInput::shared().readLine(deadline);
+        }
+        if (!action) {
+            announceTimeout();
+            co_return co_await fallback.chooseAction(players, availableActions, targetFilter);
+        }
+
+        auto it = std::find_if(players.begin(), players.end(), [&](const MySharedPtr<Player>& player) {
+            return player->getName() == trimmed(*target) && targetFilter(*player);
+        });
+
+        std::string_view actionName = trimmed(*action);
+        auto kind = std::find_if(availableActions.begin(), availableActions.end(),
+                                 [&](ActionKind available) { return actionName == actionKey(available); });
+        if (it != players.end() && kind != availableActions.end()) {
+            co_return NightAction{*kind, (*it)->getId()};
+        }
+        co_return NightAction{};
+    }
+
+    // случайность у человека только в запасном боте
+    std::uint64_t randomState() const override { return fallback.randomState(); }
+    void setRandomState(std::uint64_t state) override { fallback.setRandomState(state); }
+
+private:
+    BotStrategy fallback;
+
+    static ConsoleInput::Clock::time_point startTurn() {
+        ConsoleInput::shared().discardPending();
+        auto timeout = ConsoleInput::sharedOptions().turnTimeout;
+        return timeout.count() > 0 ? ConsoleInput::Clock::now() + timeout : ConsoleInput::Clock::time_point::max();
+    }
+
+    static void announceTimeout() {
+        std::cout << "\nВремя на ход вышло, ход сделан автоматически." << std::endl;
+    }
+
+    static std::string_view trimmed(std::string_view text) {
+        size_t begin = text.find_first_not_of(" \t\r");
+        if (begin == std::string_view::npos) {
+            return {};
+        }
+        return text.substr(begin, text.find_last_not_of(" \t\r") - begin + 1);
+    }
+};
+
+
+inline std::vector<std::string> loadNames(const std::string& fileName) {
+    std::ifstream file(fileName);
+    std::vector<std::string> names;
+    std::string name;
+
+    if (!file) {
+        std::cerr << "Не удалось открыть файл с именами.\n";
+        return names;
+    }
+
+    while (std::getline(file, name)) {
+        if (!name.empty()) {
+            names.push_back(name);
+        }
+    }
+
+    file.close();
+    return names;
+}
+
+// имена base1 .. baseN для лобби больше списка из файла. Строятся один раз, игроки на них только ссылаются
+inline std::vector<std::string> generateNames(int count, const std::string& base = "Игрок") {
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        names.push_back(base + std::to_string(i + 1));
+    }
+    return names;
+}
+
+class Doctor : public Player {
+public:
+    Doctor(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy)
+        : Player(id, Role::Doctor, name, std::move(strategy)), lastHealed(NoPlayer) {}
+
+    cppcoro::task<NightAction> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
+        NightAction action = co_await strategy->chooseAction(players, roleTraits(role).nightActions,
+                                                             TargetFilter::bind<&Doctor::canHeal>(this));
+        if (action.kind == ActionKind::Heal) {
+            lastHealed = action.target;
+        }
+        co_return action;
+    }
+
+    void saveState(PlayerState& saved) const override {
+        Player::saveState(saved);
+        saved.lastHealed = lastHealed;
+    }
+
+    void restoreState(const PlayerState& saved) override {
+        Player::restoreState(saved);
+        lastHealed = saved.lastHealed;
+    }
+
+private:
+    PlayerId lastHealed;  // не лечим одного и того же игрока два раза подряд
+
+    bool canHeal(const Player& player) const {
+        return player.isAlive() && player.getId() != lastHealed;
+    }
+};
+
+
+class Mafia : public Player {
+public:
+    Mafia(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy, Role role = Role::Mafia)
+        : Player(id, role, name, std::move(strategy)) {}
+
+    cppcoro::task<NightAction> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
+        return strategy->chooseAction(players, roleTraits(role).nightActions, TargetFilter::bind<&Mafia::isEnemy>(this));
+    }
+
+    cppcoro::task<PlayerId> vote(const std::vector<MySharedPtr<Player>>& players) override {
+        // мафия не голосует против мафии
+        return strategy->vote(players, TargetFilter::bind<&Mafia::isEnemy>(this));
+    }
+
+protected:
+    // себя фильтр отсекает тоже: мы сами из мафии
+    bool isEnemy(const Player& player) const {
+        return player.isAlive() && player.getFaction() != Faction::Mafia;
+    }
+};
+
+class Bull : public Mafia {
+public:
+    Bull(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy)
+        : Mafia(id, name, std::move(strategy), Role::Bull) {}
+};
+
+class Ninja : public Mafia {
+public:
+    Ninja(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy)
+        : Mafia(id, name, std::move(strategy), Role::Ninja) {}
+};
+
+class Killer : public Mafia {
+public:
+    Killer(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy)
+        : Mafia(id, name, std::move(strategy), Role::Killer) {}
+};
+
+class Civilian : public Player {
+public:
+    Civilian(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy)
+        : Player(id, Role::Civilian, name, std::move(strategy)) {}
+
+    cppcoro::task<NightAction> nightAction(const std::vector<MySharedPtr<Player>>&) override {
+        // мирный житель ночью ничего не делает
+        co_return NightAction{};
+    }
+};
+
+
+class Maniac : public Player {
+public:
+    Maniac(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy)
+        : Player(id, Role::Maniac, name, std::move(strategy)) {}
+
+    cppcoro::task<NightAction> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
+        return strategy->chooseAction(players, roleTraits(role).nightActions, TargetFilter::bind<&Maniac::isOther>(this));
+    }
+};
+
+
+class Commissar : public Player {
+public:
+    Commissar(PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy,
+              std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : Player(id, Role::Commissar, name, std::move(strategy)), checkedPlayers(resource) {}
+
+    void addCheckedPlayer(PlayerId playerId, bool isMafia) {
+        checkedPlayers[playerId] = isMafia;
+    }
+
+    // итоги проверок: id и «мафия». Это знание самого комиссара, его читает стратегия комиссара
+    const std::pmr::unordered_map<PlayerId, bool>& getCheckedPlayers() const { return checkedPlayers; }
+
+    cppcoro::task<NightAction> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
+        // комиссар может сделать действие над всеми, кроме себя и проверенных мирных
+        return strategy->chooseAction(players, roleTraits(role).nightActions, TargetFilter::bind<&Commissar::isSuspect>(this));
+    }
+
+    // не голосует против проверенных мирных
+    cppcoro::task<PlayerId> vote(const std::vector<MySharedPtr<Player>>& players) override {
+        return strategy->vote(players, TargetFilter::bind<&Commissar::isSuspect>(this));
+    }
+
+    void saveState(PlayerState& saved) const override {
+        Player::saveState(saved);
+        saved.checkedPlayers.assign(checkedPlayers.begin(), checkedPlayers.end());
+        std::sort(saved.checkedPlayers.begin(), saved.checkedPlayers.end());
+    }
+
+    void restoreState(const PlayerState& saved) override {
+        Player::restoreState(saved);
+        checkedPlayers.clear();
+        checkedPlayers.insert(saved.checkedPlayers.begin(), saved.checkedPlayers.end());
+    }
+
+private:
+    // id игрока и статус (true — мафия, false — мирный)
+    std::pmr::unordered_map<PlayerId, bool> checkedPlayers;
+
+    bool isCheckedAndInnocent(PlayerId playerId) const {
+        auto it = checkedPlayers.find(playerId);
+        return it != checkedPlayers.end() && !it->second;
+    }
+
+    bool isSuspect(const Player& player) const {
+        return isOther(player) && !isCheckedAndInnocent(player.getId());
+    }
+};
+
+
+
+// игрок и его блок счетчика живут в resource, обычно это арена игры
+inline MySharedPtr<Player> createPlayer(Role role, PlayerId id, const std::string& name, MySharedPtr<PlayerStrategy> strategy,
+                                 std::pmr::memory_resource* resource) {
+    switch (role) {
+        case Role::Doctor: return allocate_my_shared<Doctor>(resource, id, name, std::move(strategy));
+        case Role::Commissar: return allocate_my_shared<Commissar>(resource, id, name, std::move(strategy), resource);
+        case Role::Maniac: return allocate_my_shared<Maniac>(resource, id, name, std::move(strategy));
+        case Role::Mafia: return allocate_my_shared<Mafia>(resource, id, name, std::move(strategy));
+        case Role::Bull: return allocate_my_shared<Bull>(resource, id, name, std::move(strategy));
+        case Role::Ninja: return allocate_my_shared<Ninja>(resource, id, name, std::move(strategy));
+        case Role::Killer: return allocate_my_shared<Killer>(resource, id, name, std::move(strategy));
+        case Role::Civilian: break;
+    }
+    return allocate_my_shared<Civilian>(resource, id, name, std::move(strategy));
+}
+
+
+// корутина, которая стартует сразу и сама удаляет свой кадр, когда закончится
+struct DetachedDecision {
+    struct promise_type {
+        DetachedDecision get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+template <typename T>
+struct DecisionSlot {
+    std::optional<T> value;
+    std::exception_ptr error;
+};
+
+// без пула решение идет на текущем потоке, пока не приостановится (например, в ожидании ввода),
+// и продолжается там, где его возобновят
+template <typename T>
+DetachedDecision runDecisionOn(cppcoro::static_thread_pool* pool, cppcoro::task<T> decision, DecisionSlot<T>& slot,
+                               std::latch& done) {
+    if (pool) {
+        co_await pool->schedule();
+    }
+    try {
+        slot.value.emplace(co_await std::move(decision));
+    } catch (...) {
+        slot.error = std::current_exception();
+    }
+    // после count_down кадр только удаляет сам себя и не трогает данные потока игры
+    done.count_down();
+}
+
+// запускает все решения и ждет их; результаты в порядке задач, как у when_all.
+// в отличие от sync_wait, решения могут закончиться на любом потоке
+template <typename T>
+std::vector<T> runDecisionsOn(cppcoro::static_thread_pool* pool, std::vector<cppcoro::task<T>> decisions) {
+    std::vector<DecisionSlot<T>> slots(decisions.size());
+    std::latch done(static_cast<std::ptrdiff_t>(decisions.size()));
+    for (size_t i = 0; i < decisions.size(); ++i) {
+        runDecisionOn(pool, std::move(decisions[i]), slots[i], done);
+    }
+    done.wait();
+
+    std::vector<T> results;
+    results.reserve(slots.size());
+    for (auto& slot : slots) {
+        if (slot.error) {
+            std::rethrow_exception(slot.error);
+        }
+        results.push_back(std::move(*slot.value));
+    }
+    return results;
+}
+
+
+// голоса по номерам кандидатов в плотном массиве, без хеш-таблицы. При ничьей лидер выбирается
+// одним равновероятным выбором среди всех лидеров: если разрешать ничью попарно по ходу обхода,
+// у кандидатов ближе к концу обхода шансов больше
+class VoteTally {
+public:
+    // с пулом голоса считаются параллельно, если их хотя бы столько на поток
+    static constexpr size_t ParallelMinVotes = size_t{1} << 16;
+
+    VoteTally(size_t numCandidates, std::pmr::memory_resource* resource) : counts(numCandidates, 0, resource) {}
+
+    void add(PlayerId target) {
+        ++counts[target];
+        ++votes;
+    }
+
+    // голоса в порядке голосующих, NoPlayer — воздержался. Большую пачку на пуле делим на куски,
+    // каждый считается в свою гистограмму, потом гистограммы складываются по диапазонам кандидатов.
+    // Сумма целых от разбиения не зависит, так что итог тот же, что без пула
+    void addAll(const std::vector<PlayerId>& targets, cppcoro::static_thread_pool* pool) {
+        size_t parts = pool ? std::min<size_t>(pool->thread_count(), targets.size() / ParallelMinVotes) : 0;
+        if (parts < 2) {
+            for (PlayerId target : targets) {
+                if (target != NoPlayer) {
+                    add(target);
+                }
+            }
+            return;
+        }
+
+        std::pmr::vector<std::pmr::vector<int>> partial(counts.get_allocator());
+        partial.reserve(parts);
+        std::vector<cppcoro::task<std::uint64_t>> counting;
+        for (size_t part = 0; part < parts; ++part) {
+            partial.emplace_back(counts.size(), 0);
+            std::span<const PlayerId> chunk(targets.data() + targets.size() * part / parts,
+                                            targets.data() + targets.size() * (part + 1) / parts);
+            counting.push_back(countChunk(chunk, partial.back()));
+        }
+        for (std::uint64_t counted : runDecisionsOn(pool, std::move(counting))) {
+            votes += counted;
+        }
+
+        std::vector<cppcoro::task<std::uint64_t>> merging;
+        for (size_t part = 0; part < parts; ++part) {
+            merging.push_back(mergeRange(partial, counts.size() * part / parts, counts.size() * (part + 1) / parts));
+        }
+        runDecisionsOn(pool, std::move(merging));
+    }
+
+    int count(PlayerId candidate) const { return counts[candidate]; }
+    std::uint64_t total() const { return votes; }
+
+    int maxVotes() const {
+        return counts.empty() ? 0 : *std::max_element(counts.begin(), counts.end());
+    }
+
+    // кандидат с наибольшим числом голосов, NoPlayer — голосов не было. Генератор трогаем только при ничьей
+    PlayerId leader(std::mt19937& rng) const {
+        int best = maxVotes();
+        if (best == 0) {
+            return NoPlayer;
+        }
+        auto tied = static_cast<size_t>(std::count(counts.begin(), counts.end(), best));
+        size_t pick = tied > 1 ? std::uniform_int_distribution<size_t>(0, tied - 1)(rng) : 0;
+        for (size_t id = 0;; ++id) {
+            if (counts[id] == best && pick-- == 0) {
+                return static_cast<PlayerId>(id);
+            }
+        }
+    }
+
+    // кандидаты с голосами по возрастанию номера
+    template <typename Fn>
+    void forEachCandidate(Fn&& fn) const {
+        for (size_t id = 0; id < counts.size(); ++id) {
+            if (counts[id] > 0) {
+                fn(static_cast<PlayerId>(id), counts[id]);
+            }
+        }
+    }
+
+private:
+    std::pmr::vector<int> counts;
+    std::uint64_t votes = 0;
+
+    static cppcoro::task<std::uint64_t> countChunk(std::span<const PlayerId> targets, std::pmr::vector<int>& histogram) {
+        std::uint64_t counted = 0;
+        for (PlayerId target : targets) {
+            if (target != NoPlayer) {
+                ++histogram[target];
+                ++counted;
+            }
+        }
+        co_return counted;
+    }
+
+    cppcoro::task<std::uint64_t> mergeRange(const std::pmr::vector<std::pmr::vector<int>>& partial, size_t begin, size_t end) {
+        for (const auto& histogram : partial) {
+            for (size_t id = begin; id < end; ++id) {
+                counts[id] += histogram[id];
+            }
+        }
+        co_return end - begin;
+    }
+};
+
+// разбор ночи. Первый проход (add) раскладывает действия по правилам nightRule: голоса мафии в VoteTally,
+// убийства, лечение и проверка — в слоты ночи, а след на цели — в плотный массив эффектов по игрокам.
+// Затем resolve применяет правила по приоритетам: жертва мафии, лечение, убийства. В слоте остается
+// последнее действие, как если бы актеры ходили по очереди. Весь разбор линеен по числу актеров
+class NightResolver {
+public:
+    // эффекты ночи на игроке, по биту на эффект
+    enum Effect : std::uint8_t {
+        Targeted = 1 << 0,  // на игрока направлено хотя бы одно действие
+        Healed = 1 << 1,
+        Immune = 1 << 2,    // иммунитет остановил удар
+        Killed = 1 << 3,
+        Checked = 1 << 4
+    };
+
+    // кто и на кого направил действие; NoPlayer — никто
+    struct Slot {
+        PlayerId actor = NoPlayer;
+        PlayerId target = NoPlayer;
+    };
+
+    // что сделало действие: правило и остановил ли удар иммунитет цели
+    struct Applied {
+        NightRule rule = NightRule::None;
+        bool stopped = false;
+    };
+
+    NightResolver(size_t numPlayers, std::pmr::memory_resource* resource)
+        : effects(numPlayers, 0, resource), mafiaVotes(numPlayers, resource) {}
+
+    Applied add(PlayerId actor, Role actorRole, NightAction action, Role targetRole) {
+        const NightRule rule = nightRule(actorRole, action.kind);
+        if (rule == NightRule::None || action.target == NoPlayer) {
+            return {};
+        }
+        effects[action.target] |= Targeted;
+        switch (rule) {
+            case NightRule::MafiaVote:
+                mafiaVotes.add(action.target);
+                break;
+            case NightRule::Kill: {
+                const int priority = roleTraits(actorRole).killPriority;
+                if (killRules[priority].stoppedByImmunity && roleTraits(targetRole).immuneToManiac) {
+                    effects[action.target] |= Immune;
+                    return {rule, true};
+                }
+                kills[priority] = {actor, action.target};
+                break;
+            }
+            case NightRule::Heal:
+                heal = {actor, action.target};
+                break;
+            case NightRule::Check:
+                check = {actor, action.target};
+                break;
+            case NightRule::None:
+                break;
+        }
+        return {rule, false};
+    }
+
+    // генератор нужен только для ничьей в голосе мафии
+    void resolve(std::mt19937& rng) {
+        kills[MafiaKillPriority].target = mafiaVotes.leader(rng);
+        if (heal.target != NoPlayer) {
+            effects[heal.target] |= Healed;
+        }
+        for (const Slot& kill : kills) {
+            if (kill.target == NoPlayer) {
+                continue;
+            }
+            if (effects[kill.target] & Healed) {
+                saved = true;
+            } else {
+                effects[kill.target] |= Killed;
+            }
+        }
+        if (check.target != NoPlayer) {
+            effects[check.target] |= Checked;
+        }
+    }
+
+    bool has(PlayerId id, Effect effect) const { return effects[id] & effect; }
+
+    // убийство с приоритетом priority; у жертвы мафии actor — NoPlayer
+    const Slot& kill(int priority) const { return kills[priority]; }
+    const Slot& healing() const { return heal; }
+    const Slot& checking() const { return check; }
+
+    // лечение спасло хотя бы от одного убийства
+    bool healSaved() const { return saved; }
+
+private:
+    std::pmr::vector<std::uint8_t> effects;
+    VoteTally mafiaVotes;
+    std::array<Slot, KillPriorityCount> kills{};
+    Slot heal;
+    Slot check;
+    bool saved = false;
+};
+
+enum class Winner {
+    None,
+    Mafia,
+    Civilians,
+    Maniac
+};
+
+class GameMaster {
+public:
+    // стратегия бота на месте id с его сидом; память для нее берется из resource. Нужна турниру
+    using StrategyFactory = FunctionRef<MySharedPtr<PlayerStrategy>(PlayerId id, std::uint64_t seed,
+                                                                    std::pmr::memory_resource* resource)>;
+
+    // headless — без ввода/вывода в консоль и без текстовых логов, для пакетной симуляции.
+    // иначе подробность вывода берется из ConsoleRenderer::sharedOptions().
+    // все случайные решения игры берутся из одного генератора, так что игра с тем же сидом повторяется.
+    // игроки и временные данные фаз живут в arena, ее сбрасывают после уничтожения игры;
+    // arena и names должны пережить игру: игроки не копируют имена, а ссылаются на элементы names,
+    // так что вектор нельзя ни уничтожать, ни менять, пока игра жива.
+    // botStrategies вызывается только в конструкторе; без нее все боты — BotStrategy
+    GameMaster(GameArena& arena, int numPlayers, bool isUserPlayer, const std::vector<std::string>& names, std::uint64_t seed,
+               bool headless = false, StrategyFactory botStrategies = nullptr)
+        : arena(arena), numPlayers(numPlayers), isUserPlayer(isUserPlayer), headless(headless), currentDay(1),
+          winner(Winner::None), seed(seed), rng(makeRng(seed)), names(names), state(numPlayers, arena.game()),
+          logger(!headless), console(consoleVerbosity(headless)) {
+        logger.add(LogSink::Day, LogLevel::Summary, "Сид игры: ", seed, '\n');
+        assignRoles(botStrategies);
+        logger.commit(LogSink::Day, 0);
+    }
+
+    // продолжение игры со снимка. В headless человек (если был) играет ботом со своим запасным генератором
+    GameMaster(GameArena& arena, const GameSnapshot& snapshot, bool headless = false)
+        : arena(arena), numPlayers(snapshot.numPlayers), isUserPlayer(snapshot.isUserPlayer && !headless), headless(headless),
+          currentDay(snapshot.currentDay), winner(static_cast<Winner>(snapshot.winner)), seed(snapshot.seed), rng(snapshot.rng),
+          names(ownNames), state(snapshot.numPlayers, arena.game()), logger(!headless), console(consoleVerbosity(headless)) {
+        // имена берем к себе: снимок может умереть раньше игры. Место резервируем, чтобы ссылки игроков не съехали
+        ownNames.reserve(snapshot.players.size());
+        players.reserve(numPlayers);
+        for (size_t i = 0; i < snapshot.players.size(); ++i) {
+            const PlayerRecord& record = *snapshot.players[i];
+            MySharedPtr<PlayerStrategy> strategy;
+            if (isUserPlayer && record.id == 0) {
+                strategy = allocate_my_shared<UserStrategy>(arena.game(), snapshot.playerRngs[i]);
+            } else {
+                strategy = allocate_my_shared<BotStrategy>(arena.game(), snapshot.playerRngs[i]);
+            }
+            ownNames.push_back(record.name);
+            addPlayer(createPlayer(record.role, record.id, ownNames.back(), std::move(strategy), arena.game()));
+            players.back()->restoreState(record.state);
+            if (!record.state.alive) {
+                state.kill(record.id);
+                --aliveByFaction[static_cast<size_t>(players.back()->getFaction())];
+            }
+        }
+        playersToReveal.assign(snapshot.playersToReveal.begin(), snapshot.playersToReveal.end());
+        healedPlayers.assign(snapshot.healedPlayers.begin(), snapshot.healedPlayers.end());
+        events.assign(snapshot.events);
+        nightNext = snapshot.nightNext;
+        lastRecords = snapshot.players;
+        logger.add(LogSink::Day, LogLevel::Summary, "Игра продолжена со снимка, сид игры: ", seed, '\n');
+        logger.commit(LogSink::Day, currentDay);
+    }
+
+    // игроки ссылаются на имена из names или ownNames: копия или перемещение оставили бы их ссылки на чужие строки
+    GameMaster(const GameMaster&) = delete;
+    GameMaster& operator=(const GameMaster&) = delete;
+    GameMaster(GameMaster&&) = delete;
+    GameMaster& operator=(GameMaster&&) = delete;
+
+    // снимок между фазами. Записи игроков, которые не изменились с прошлого снимка, общие с ним
+    GameSnapshot snapshot() {
+        GameSnapshot snapshot;
+        snapshot.seed = seed;
+        snapshot.numPlayers = numPlayers;
+        snapshot.isUserPlayer = isUserPlayer;
+        snapshot.currentDay = currentDay;
+        snapshot.nightNext = nightNext;
+        snapshot.winner = static_cast<std::uint8_t>(winner);
+        snapshot.rng = rng;
+        snapshot.players.reserve(players.size());
+        snapshot.playerRngs.reserve(players.size());
+        for (const auto& player : players) {
+            PlayerState current;
+            player->saveState(current);
+            size_t id = static_cast<size_t>(player->getId());
+            if (id < lastRecords.size() && lastRecords[id]->state == current) {
+                snapshot.players.push_back(lastRecords[id]);
+            } else {
+                snapshot.players.push_back(make_my_atomic_shared<PlayerRecord>(
+                    PlayerRecord{player->getId(), player->getRole(), player->getName(), std::move(current)}));
+            }
+            snapshot.playerRngs.push_back(player->getStrategy()->randomState());
+        }
+        snapshot.playersToReveal.assign(playersToReveal.begin(), playersToReveal.end());
+        snapshot.healedPlayers.assign(healedPlayers.begin(), healedPlayers.end());
+        snapshot.events = events.records();
+        lastRecords = snapshot.players;
+        return snapshot;
+    }
+
+    // новый сид для игры и всех стратегий: продолжения одного снимка расходятся
+    void reseed(std::uint64_t newSeed) {
+        seed = newSeed;
+        rng = makeRng(newSeed);
+        for (const auto& player : players) {
+            player->getStrategy()->setRandomState(SplitMix64::streamSeed(newSeed, player->getId()));
+        }
+    }
+
+    // перед каждой фазой снимок пишется в path, после конца игры файл удаляется
+    void enableCheckpoints(const std::string& path) {
+        checkpointPath = path;
+    }
+
+    // следующая фаза, день или ночь; false — игра уже окончена
+    bool playNextPhase() {
+        if (isGameOver()) {
+            return false;
+        }
+        saveCheckpoint();
+        std::uint64_t allocationsBefore = AllocationCounter::count();
+        if (nightNext) {
+            playNightPhase();
+            announceNightResults();
+            ++currentDay;
+        } else {
+            playDayPhase();
+        }
+        countPhaseAllocations(allocationsBefore);
+        nightNext = !nightNext;
+        return true;
+    }
+
+    void runGame() {
+        MAFIA_TIME_SECTION(MetricSection::Game);
+        MAFIA_COUNT(MetricCounter::Games, 1);
+        while (playNextPhase()) {
+        }
+
+        if (!checkpointPath.empty()) {
+            std::error_code error;
+            std::filesystem::remove(checkpointPath, error);
+        }
+
+        if (!eventLogPath.empty()) {
+            events.record(currentDay, EventPhase::End, EventAction::GameOver, NoEventPlayer, NoEventPlayer,
+                          static_cast<std::uint32_t>(winner));
+            AsyncLogWriter::shared().write(eventLogPath, events.encode(seed, static_cast<std::uint32_t>(players.size())));
+            events.clear();
+        }
+    }
+
+    // включает бинарный журнал событий; блок игры дописывается в файл, когда игра закончится
+    void enableEventLog(const std::string& path) {
+        eventLogPath = path;
+        if (!events.empty()) {
+            return;  // игра со снимка, роли уже записаны
+        }
+        for (const auto& player : players) {
+            recordEvent(EventPhase::Setup, EventAction::AssignRole, player->getId(), NoPlayer,
+                        static_cast<std::uint32_t>(player->getRole()));
+        }
+    }
+
+    // решения игроков одной фазы выполняются параллельно на пуле. У каждого бота свой генератор,
+    // а результаты разбираются в порядке id, так что исход игры от пула не зависит.
+    // пул должен пережить игру
+    void setDecisionPool(cppcoro::static_thread_pool* pool) {
+        decisionPool = pool;
+    }
+
+    Winner getWinner() const { return winner; }
+    const std::vector<MySharedPtr<Player>>& getPlayers() const { return players; }
+    int getCurrentDay() const { return currentDay; }
+    std::uint64_t getSeed() const { return seed; }
+    // выделения памяти в куче внутри дневных и ночных фаз этой игры
+    std::uint64_t getPhaseAllocations() const { return phaseAllocations; }
+    int getPhasesPlayed() const { return phasesPlayed; }
+
+private:
+    GameArena& arena;
+    int numPlayers;
+    bool isUserPlayer;
+    bool headless;
+    int currentDay;
+    Winner winner;
+    std::uint64_t seed;
+    std::mt19937 rng;
+    // имена, которых нет в общем списке: имя человека и имена игры со снимка
+    std::vector<std::string> ownNames;
+    const std::vector<std::string>& names;
+    std::vector<MySharedPtr<Player>> players;
+    std::vector<PlayerId> playersToReveal;
+    std::vector<PlayerId> healedPlayers;
+    // живые игроки по сторонам, обновляются в addPlayer/killPlayer, чтобы isGameOver был O(1)
+    std::array<int, FactionCount> aliveByFaction{};
+    // маски живых и сторон; фазы обходят живых по ним, а не по объектам игроков
+    GameState state;
+
+    Logger logger;
+    ConsoleRenderer console;
+    std::string eventLogPath;
+    EventLogBuffer events;
+    std::uint64_t phaseAllocations = 0;
+    int phasesPlayed = 0;
+    cppcoro::static_thread_pool* decisionPool = nullptr;
+    bool nightNext = false;  // день уже сыгран, следующей идет ночь
+    std::string checkpointPath;
+    std::vector<MyAtomicSharedPtr<const PlayerRecord>> lastRecords;  // записи прошлого снимка
+
+    void saveCheckpoint() {
+        if (checkpointPath.empty()) return;
+        if (!saveSnapshot(checkpointPath, snapshot()) && !headless) {
+            std::cerr << "Не удалось сохранить снимок игры в " << checkpointPath << "\n";
+        }
+    }
+
+    static Verbosity consoleVerbosity(bool headless) {
+        return headless ? Verbosity::Silent : ConsoleRenderer::sharedOptions().verbosity;
+    }
+
+    // решения человека заканчиваются на потоке ввода, поэтому с ним, как и с пулом, ждем через runDecisionsOn.
+    // приглашения человеку UserStrategy пишет сама, так что накопленный вывод фазы отдаем до них
+    template <typename T>
+    std::vector<T> awaitDecisions([[maybe_unused]] MetricSection section, std::vector<cppcoro::task<T>> decisions) {
+        MAFIA_TIME_SECTION(section);
+        if (isUserPlayer) {
+            console.flush();
+        }
+        if (decisionPool || isUserPlayer) {
+            return runDecisionsOn(decisionPool, std::move(decisions));
+        }
+        return cppcoro::sync_wait(cppcoro::when_all(std::move(decisions)));
+    }
+
+    void countPhaseAllocations(std::uint64_t allocationsBefore) {
+        phaseAllocations += AllocationCounter::count() - allocationsBefore;
+        ++phasesPlayed;
+    }
+
+    static std::mt19937 makeRng(std::uint64_t seed) {
+        std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32)};
+        return std::mt19937(seq);
+    }
+
+
+    MySharedPtr<PlayerStrategy> makeBotStrategy(PlayerId id, StrategyFactory botStrategies) {
+        std::uint64_t botSeed = SplitMix64::streamSeed(seed, id);
+        if (botStrategies) {
+            return botStrategies(id, botSeed, arena.game());
+        }
+        return allocate_my_shared<BotStrategy>(arena.game(), botSeed);
+    }
+
+    void assignRandomRole(const std::string& playerName, int& numMafia, int& numDoctors, int& numCommissars, int& numManiacs, int& numCivilians, 
+                      std::pmr::vector<PlayerId>& mafiaIds, bool& bullAssigned, bool& ninjaAssigned, bool& killerAssigned,
+                      StrategyFactory botStrategies = nullptr) {
+    PlayerId id = static_cast<PlayerId>(players.size());
+    std::uniform_int_distribution<int> roleDistr(0, numMafia + numDoctors + numCommissars + numManiacs + numCivilians - 1);
+    int randomRole = roleDistr(rng);
+    Role role;
+    
+    if (randomRole < numMafia) {
+        int mafiaType = std::uniform_int_distribution<int>(0, 3)(rng);
+        
+        if (mafiaType == 0 || (bullAssigned && ninjaAssigned && killerAssigned)) {
+            role = Role::Mafia;
+        } else if (mafiaType == 1 && !bullAssigned) {
+            role = Role::Bull;
+            bullAssigned = true; 
+        } else if (mafiaType == 2 && !ninjaAssigned) {
+            role = Role::Ninja;
+            ninjaAssigned = true; 
+        } else if (mafiaType == 3 && !killerAssigned) {
+            role = Role::Killer;
+            killerAssigned = true; 
+        } else {
+            role = Role::Mafia;
+        }
+        
+        mafiaIds.push_back(id);
+        numMafia--;
+    } else if (randomRole < numMafia + numDoctors) {
+        role = Role::Doctor;
+        numDoctors--;
+    } else if (randomRole < numMafia + numDoctors + numCommissars) {
+        role = Role::Commissar;
+        numCommissars--;
+    } else if (randomRole < numMafia + numDoctors + numCommissars + numManiacs) {
+        role = Role::Maniac;
+        numManiacs--;
+    } else {
+        role = Role::Civilian;
+        numCivilians--;
+    }
+
+    addPlayer(createPlayer(role, id, playerName, makeBotStrategy(id, botStrategies), arena.game()));
+    logger.add(LogSink::Day, LogLevel::Detail, playerName, " получил роль: ", roleTraits(role).name, '\n');
+}
+
+
+
+void assignRoles(StrategyFactory botStrategies) {
+    MAFIA_TIME_SECTION(MetricSection::AssignRoles);
+    if (names.size() < static_cast<size_t>(numPlayers)) {
+        if (!headless) {
+            std::cerr << "\n*** Недостаточно имен в файле для игры. Минимум " << numPlayers << ". ***\n";
+        }
+        return;
+    }
+
+    players.reserve(numPlayers);
+
+    // перемешиваем номера, а не сами имена: перестановка та же, но список имен не копируется
+    std::pmr::vector<int> order(names.size(), arena.game());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = static_cast<int>(i);
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+
+    int numMafia = std::max(1, numPlayers / 5);
+    int numDoctors = 1;
+    int numCommissars = 1;
+    int numManiacs = 1;
+    int numCivilians = numPlayers - numMafia - numDoctors - numCommissars - numManiacs;
+
+    std::pmr::vector<PlayerId> mafiaIds(arena.game());
+
+    bool bullAssigned = false;
+    bool ninjaAssigned = false;
+    bool killerAssigned = false;
+
+    if (isUserPlayer) {
+        // игрок ссылается на имя, так что оно хранится в игре, а не в локальной переменной
+        std::string& playerName = ownNames.emplace_back();
+        std::cout << "Введите свое имя: ";
+        std::cin >> playerName;
+        std::cout << "Выберите роль (mafia, bull, ninja, killer, doctor, commissar, maniac, civilian) или нажмите Enter для случайного выбора: ";
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        std::string role;
+        std::getline(std::cin, role);
+
+        PlayerId id = static_cast<PlayerId>(players.size());
+        Role chosenRole;
+
+        if (roleFromKey(role, chosenRole)) {
+            addPlayer(createPlayer(chosenRole, id, playerName, allocate_my_shared<UserStrategy>(arena.game(), SplitMix64::streamSeed(seed, id)), arena.game()));
+            logger.add(LogSink::Day, LogLevel::Detail, playerName, " получил роль: ", roleTraits(chosenRole).name, '\n');
+
+            switch (chosenRole) {
+                case Role::Bull: bullAssigned = true; break;
+                case Role::Ninja: ninjaAssigned = true; break;
+                case Role::Killer: killerAssigned = true; break;
+                case Role::Doctor: numDoctors--; break;
+                case Role::Commissar: numCommissars--; break;
+                case Role::Maniac: numManiacs--; break;
+                case Role::Civilian: numCivilians--; break;
+                case Role::Mafia: break;
+            }
+            if (isMafiaRole(chosenRole)) {
+                mafiaIds.push_back(id);
+                numMafia--;
+            }
+        } else {
+            assignRandomRole(playerName, numMafia, numDoctors, numCommissars, numManiacs, numCivilians, mafiaIds, bullAssigned, ninjaAssigned, killerAssigned);
+            // наш игрок ходит сам, а не бот; роль та же, так что счетчики не меняются
+            players.back() = createPlayer(players.back()->getRole(), id, playerName, allocate_my_shared<UserStrategy>(arena.game(), SplitMix64::streamSeed(seed, id)),
+                                          arena.game());
+        }
+
+        order.erase(std::remove_if(order.begin(), order.end(), [&](int i) { return names[i] == playerName; }), order.end());
+    }
+
+    
+    for (int nameIndex : order) {
+        assignRandomRole(names[nameIndex], numMafia, numDoctors, numCommissars, numManiacs, numCivilians, mafiaIds, bullAssigned, ninjaAssigned, killerAssigned,
+                         botStrategies);
+        if (players.size() == static_cast<size_t>(numPlayers)) break;
+    }
+
+    
+    // наш игрок всегда первый, с id 0
+    if (isUserPlayer && console.shows(Verbosity::Summary) && std::find(mafiaIds.begin(), mafiaIds.end(), 0) != mafiaIds.end()) {
+        console.print(Verbosity::Summary, "\nВы — мафиози! Вот список всех мафиози:\n");
+        for (PlayerId id : mafiaIds) {
+            if (id != 0) {
+                console.print(Verbosity::Summary, "- ", nameOf(id), '\n');
+            }
+        }
+    }
+
+    if (console.shows(Verbosity::Full)) {
+        console.print(Verbosity::Full, "\n========== ИГРОКИ В ЭТОЙ ИГРЕ ==========\n");
+        for (const auto& player : players) {
+            console.print(Verbosity::Full, "- ", player->getName(), '\n');
+        }
+        console.print(Verbosity::Full, "=========================================\n\n");
+    }
+    console.flush();
+}
+    
+
+    void recordEvent(EventPhase phase, EventAction action, PlayerId actor, PlayerId target, std::uint32_t outcome = 0) {
+        if (eventLogPath.empty()) return;
+        events.record(currentDay, phase, action, eventPlayerId(actor), eventPlayerId(target), outcome);
+    }
+
+    static std::uint32_t eventPlayerId(PlayerId id) {
+        return id == NoPlayer ? NoEventPlayer : static_cast<std::uint32_t>(id);
+    }
+
+
+public:
+    // шаги игры по отдельности: runGame — это они в цикле. Снаружи нужны бенчмарку
+    void playNightPhase() {
+        MAFIA_TIME_SECTION(MetricSection::NightPhase);
+        arena.resetPhase();
+        NightResolver night(players.size(), arena.phase());
+
+        logger.add(LogSink::Night, LogLevel::Summary, "НОЧЬ ", currentDay, " НАСТУПИЛА. Начались ночные действия.\n");
+
+        // when_all принимает только std::vector
+        std::vector<cppcoro::task<NightAction>> nightTasks;
+        std::pmr::vector<PlayerId> alivePlayers(arena.phase());
+        const size_t numAlive = state.countAlive();
+        alivePlayers.reserve(numAlive);
+        nightTasks.reserve(numAlive);
+
+        state.forEachAlive([&](PlayerId id) {
+            alivePlayers.push_back(id);
+            nightTasks.push_back(players[id]->nightAction(players));
+        });
+
+        auto results = awaitDecisions(MetricSection::CollectNightActions, std::move(nightTasks));
+        MAFIA_TIME_SECTION(MetricSection::ResolveNight);
+
+        for (size_t i = 0; i < alivePlayers.size(); ++i) {
+            const NightAction action = results[i];
+            const PlayerId actor = alivePlayers[i];
+            if (action.kind == ActionKind::None || action.target == NoPlayer) {
+                continue;
+            }
+            MAFIA_COUNT(MetricCounter::NightActions, 1);
+            logger.add(LogSink::Night, LogLevel::Detail, nameOf(actor), " совершает действие: ", actionKey(action.kind), " на ",
+                       nameOf(action.target), ".\n");
+
+            const Role actorRole = state.role(actor);
+            const auto applied = night.add(actor, actorRole, action, state.role(action.target));
+            if (applied.rule == NightRule::MafiaVote) {
+                recordEvent(EventPhase::Night, EventAction::MafiaVote, actor, action.target);
+            } else if (applied.stopped) {
+                logger.add(LogSink::Night, LogLevel::Summary, killRules[roleTraits(actorRole).killPriority].failedMessage,
+                           nameOf(action.target), ", но это был Бык, и он не был убит.\n");
+                recordEvent(EventPhase::Night, EventAction::Kill, actor, action.target, 0);
+            }
+        }
+
+        night.resolve(rng);
+
+        for (int priority = 0; priority < KillPriorityCount; ++priority) {
+            if (night.kill(priority).target != NoPlayer) {
+                logger.add(LogSink::Night, LogLevel::Summary, killRules[priority].chosenMessage, nameOf(night.kill(priority).target), ".\n");
+            }
+        }
+
+        const NightResolver::Slot& heal = night.healing();
+        if (heal.target != NoPlayer) {
+            if (night.healSaved()) {
+                healedPlayers.push_back(heal.target);
+            }
+            logger.add(LogSink::Night, LogLevel::Summary, "Доктор лечит: ", nameOf(heal.target), ".\n");
+            recordEvent(EventPhase::Night, EventAction::Heal, heal.actor, heal.target, night.healSaved());
+        }
+
+        for (int priority = 0; priority < KillPriorityCount; ++priority) {
+            const NightResolver::Slot& kill = night.kill(priority);
+            if (kill.target == NoPlayer) {
+                continue;
+            }
+            bool killed = night.has(kill.target, NightResolver::Killed);
+            recordEvent(EventPhase::Night, EventAction::Kill, kill.actor, kill.target, killed);
+            if (killed) {
+                // двое могли выбрать одну жертву: объявляем ее один раз, без поиска по списку
+                if (killPlayer(kill.target, DeathReveal::Role)) {
+                    playersToReveal.push_back(kill.target);
+                }
+                logger.add(LogSink::Night, LogLevel::Summary, killRules[priority].doneMessage, nameOf(kill.target), ".\n");
+            }
+        }
+
+        const NightResolver::Slot& check = night.checking();
+        if (check.target != NoPlayer) {
+            PlayerId checkTarget = check.target;
+            // проверять умеет только комиссар (см. static_assert в Roles.h), так что приведение безопасно
+            auto* checkingCommissar = static_cast<Commissar*>(players[check.actor].get());
+            bool isMafia = roleTraits(state.role(checkTarget)).visibleToCommissar;
+            checkingCommissar->addCheckedPlayer(checkTarget, isMafia);
+            recordEvent(EventPhase::Night, EventAction::Check, check.actor, checkTarget, isMafia);
+
+            logger.add(LogSink::Night, LogLevel::Summary, "Комиссар проверил: ", nameOf(checkTarget), ". Это ",
+                       isMafia ? "мафия.\n" : "не мафия.\n");
+
+            if (console.shows(Verbosity::Summary) && dynamic_cast<UserStrategy*>(checkingCommissar->getStrategy().get())) {
+                console.print(Verbosity::Summary, "\nРезультат проверки: ", nameOf(checkTarget), " — ",
+                              isMafia ? "мафия.\n" : "не мафия.\n");
+            }
+        }
+        logger.add(LogSink::Night, LogLevel::Summary, '\n');
+        logger.commit(LogSink::Night, currentDay);
+    }
+
+private:
+    // имена нужны только для вывода и логов, внутри игры игроки адресуются по id
+    const std::string& nameOf(PlayerId id) const {
+        return players[id]->getName();
+    }
+
+    void addPlayer(MySharedPtr<Player> player) {
+        ++aliveByFaction[static_cast<size_t>(player->getFaction())];
+        state.addPlayer(player->getId(), player->getRole());
+        players.push_back(std::move(player));
+    }
+
+    // false — игрок уже был мертв. reveal — что о нем объявят, по этому стратегии судят о мертвых
+    bool killPlayer(PlayerId id, DeathReveal reveal) {
+        const auto& player = players[id];
+        assert(player->isAlive() == state.isAlive(id) && "маска живых разошлась с игроками");
+        if (!player->isAlive()) {
+            return false;
+        }
+        player->die(reveal);
+        state.kill(id);
+        MAFIA_COUNT(MetricCounter::Kills, 1);
+        --aliveByFaction[static_cast<size_t>(player->getFaction())];
+        return true;
+    }
+
+    // пересчет по маскам: AND и popcount вместо обхода всех игроков
+    std::array<int, FactionCount> recountAliveByFaction() const {
+        std::array<int, FactionCount> alive{};
+        for (size_t faction = 0; faction < FactionCount; ++faction) {
+            alive[faction] = state.countAlive(static_cast<Faction>(faction));
+        }
+        return alive;
+    }
+
+    // вывод ночи (и результат проверки комиссара-человека из playNightPhase) уходит в консоль здесь, одной записью
+    void announceNightResults() {
+        MAFIA_TIME_SECTION(MetricSection::AnnounceNight);
+        if (console.shows(Verbosity::Summary)) {
+            console.print(Verbosity::Summary, "\n========== РЕЗУЛЬТАТЫ НОЧИ ==========\n");
+            for (PlayerId playerId : playersToReveal) {
+                const auto& player = players[playerId];
+                console.print(Verbosity::Summary, "\n*** ", player->getName(), " был убит прошлой ночью. Он был ",
+                              roleTraits(player->getRole()).revealName, ". ***\n");
+            }
+
+            for (PlayerId playerId : healedPlayers) {
+                console.print(Verbosity::Summary, "\n*** ", nameOf(playerId), " был спасен прошлой ночью доктором. ***\n");
+            }
+            console.print(Verbosity::Summary, "======================================\n\n");
+        }
+        console.flush();
+        playersToReveal.clear();
+        healedPlayers.clear();
+    }
+
+public:
+   bool isGameOver() {
+    // в отладочной сборке сверяем счетчики с полным пересчетом
+    assert(aliveByFaction == recountAliveByFaction() && "счетчики живых игроков разошлись с пересчетом");
+
+    int numMafia = aliveByFaction[static_cast<size_t>(Faction::Mafia)];
+    int numCivilians = aliveByFaction[static_cast<size_t>(Faction::Civilians)];
+    int numManiac = aliveByFaction[static_cast<size_t>(Faction::Maniac)];
+
+    if (numMafia > numCivilians) {
+        winner = Winner::Mafia;
+        console.print(Verbosity::Summary, "\n*** Мафия победила! Количество мафов больше количества мирных жителей. ***\n",
+                      "Осталось:\n- Мафия: ", numMafia, "\n- Мирные жители: ", numCivilians, '\n');
+        console.flush();
+
+        logFinalResult("Мафия победила. Количество мафов больше количества мирных жителей.\n", "Остаток мафии: ", numMafia,
+                       "\nОстаток мирных жителей: ", numCivilians, '\n');
+        return true;
+    }
+
+    if (numMafia == numCivilians && numManiac == 0) {
+        winner = Winner::Mafia;
+        console.print(Verbosity::Summary, "\n*** Мафия победила! Количество мафов равно количеству мирных жителей. ***\n",
+                      "Осталось:\n- Мафия: ", numMafia, "\n- Мирные жители: ", numCivilians, '\n');
+        console.flush();
+
+        logFinalResult("Мафия победила. Количество мафов равно количеству мирных жителей.\n", "Остаток мафии: ", numMafia,
+                       "\nОстаток мирных жителей: ", numCivilians, '\n');
+        return true;
+    }
+
+    if (numMafia == 0 && numManiac == 0) {
+        winner = Winner::Civilians;
+        console.print(Verbosity::Summary, "\n*** Мирные жители победили! Все мафы и маньяк убиты. ***\n",
+                      "Осталось:\n- Мирные жители: ", numCivilians, '\n');
+        console.flush();
+
+        logFinalResult("Мирные жители победили. Все мафы и маньяк убиты.\n", "Остаток мирных жителей: ", numCivilians, '\n');
+        return true;
+    }
+
+    if (numManiac == 1 && numMafia == 0 && numCivilians == 1) {
+        winner = Winner::Maniac;
+        console.print(Verbosity::Summary, "\n*** Маньяк победил! Он остался один на один с мирным жителем. ***\n",
+                      "Осталось:\n- Маньяк: 1\n- Мирные жители: ", numCivilians, '\n');
+        console.flush();
+
+        logFinalResult("Маньяк победил. Он остался один на один с мирным жителем.\n", "Остаток маньяка: 1\nОстаток мирных жителей: ",
+                       numCivilians, '\n');
+        return true;
+    }
+
+    // маньяк, оставшийся один, тоже побеждает — иначе игра не закончится
+    if (numManiac == 1 && numMafia == 0 && numCivilians == 0) {
+        winner = Winner::Maniac;
+        console.print(Verbosity::Summary, "\n*** Маньяк победил! Он остался единственным живым игроком. ***\n",
+                      "Осталось:\n- Маньяк: 1\n");
+        console.flush();
+
+        logFinalResult("Маньяк победил. Он остался единственным живым игроком.\n", "Остаток маньяка: 1\n");
+        return true;
+    }
+
+    return false;
+}
+
+private:
+// outcome — поля строк об исходе игры, см. Logger::add
+template <typename... Fields>
+void logFinalResult(const Fields&... outcome) {
+    logger.add(LogSink::Result, LogLevel::Summary, "РЕЗУЛЬТАТЫ ИГРЫ:\n", outcome..., "СОСТОЯНИЕ ИГРОКОВ:\n");
+    if (logger.isEnabled(LogSink::Result, LogLevel::Detail)) {
+        for (const auto& player : players) {
+            logger.add(LogSink::Result, LogLevel::Detail, "Имя: ", player->getName(), ", Роль: ", roleTraits(player->getRole()).title,
+                       ", Статус: ", player->isAlive() ? "Жив" : "Мертв", '\n');
+        }
+    }
+    logger.add(LogSink::Result, LogLevel::Summary, "=====================================\n\n");
+    logger.commit(LogSink::Result, currentDay);
+}
+
+
+public:
+   void playDayPhase() {
+    MAFIA_TIME_SECTION(MetricSection::DayPhase);
+    console.print(Verbosity::Summary, "\n********** ДЕНЬ ", currentDay, " НАСТУПИЛ **********\n");
+    arena.resetPhase();
+    VoteTally voteCount(players.size(), arena.phase());
+    // голоса по одному нужны только полному выводу
+    const bool showVotes = console.shows(Verbosity::Full);
+    std::pmr::vector<std::pair<PlayerId, PlayerId>> playerVotes(arena.phase());
+
+    std::pmr::vector<PlayerId> voters(arena.phase());
+    voters.reserve(state.countAlive());
+    state.forEachAlive([&](PlayerId id) { voters.push_back(id); });
+
+    // when_all принимает только std::vector
+    std::vector<cppcoro::task<PlayerId>> voteTasks;
+    voteTasks.reserve(voters.size());
+    for (PlayerId voter : voters) {
+        voteTasks.push_back(players[voter]->vote(players));
+    }
+
+    auto results = awaitDecisions(MetricSection::CollectVotes, std::move(voteTasks));
+
+    logger.add(LogSink::Day, LogLevel::Summary, "ДЕНЬ ", currentDay, " НАСТУПИЛ. Началось голосование.\n");
+
+    // подсчет и выбор казненного идут до вывода: вывод генератор не трогает, так что порядок не важен
+    PlayerId eliminatedPlayer = NoPlayer;
+    int maxVotes = 0;
+    {
+        MAFIA_TIME_SECTION(MetricSection::TallyVotes);
+        voteCount.addAll(results, decisionPool);
+        for (size_t i = 0; i < voters.size(); ++i) {
+            PlayerId target = results[i];
+            if (target == NoPlayer) {
+                continue;
+            }
+            if (showVotes) {
+                playerVotes.emplace_back(voters[i], target);
+            }
+            recordEvent(EventPhase::Day, EventAction::Vote, voters[i], target);
+            logger.add(LogSink::Day, LogLevel::Detail, "Игрок ", nameOf(voters[i]), " голосует за ", nameOf(target), ".\n");
+        }
+        eliminatedPlayer = voteCount.leader(rng);
+        maxVotes = voteCount.maxVotes();
+        MAFIA_COUNT(MetricCounter::Votes, voteCount.total());
+    }
+
+    if (showVotes) {
+        MAFIA_TIME_SECTION(MetricSection::Output);
+        console.print(Verbosity::Full, "\n========== ДНЕВНОЕ ГОЛОСОВАНИЕ ==========\n");
+        for (const auto& [voter, target] : playerVotes) {
+            console.print(Verbosity::Full, nameOf(voter), " голосует за ", nameOf(target), '\n');
+        }
+        console.print(Verbosity::Full, "------------------------------------------\n");
+        
+        console.print(Verbosity::Full, "РЕЗУЛЬТАТЫ ГОЛОСОВАНИЯ:\n");
+        voteCount.forEachCandidate([&](PlayerId candidate, int count) {
+            console.print(Verbosity::Full, nameOf(candidate), ": ", count, '\n');
+        });
+        console.print(Verbosity::Full, "==========================================\n\n");
+    }
+
+    if (logger.isEnabled(LogSink::Day, LogLevel::Detail)) {
+        voteCount.forEachCandidate([&](PlayerId candidate, int count) {
+            logger.add(LogSink::Day, LogLevel::Detail, nameOf(candidate), " получил ", count, " голосов.\n");
+        });
+    }
+
+    if (eliminatedPlayer != NoPlayer) {
+        const auto& eliminated = players[eliminatedPlayer];
+        const std::string& eliminatedName = eliminated->getName();
+        killPlayer(eliminatedPlayer, DeathReveal::Faction);
+        bool wasMafia = eliminated->getFaction() == Faction::Mafia;
+
+        console.print(Verbosity::Summary, "*** ", eliminatedName, " был казнен днем. ***\n",
+                      wasMafia ? "*** Он был мафией. ***\n" : "*** Он был не мафией. ***\n");
+
+        logger.add(LogSink::Day, LogLevel::Summary, "\nИгрок ", eliminatedName,
+                   wasMafia ? " был казнен и он был мафией.\n" : " был казнен и он был не мафией.\n",
+                   "\nИгрок ", eliminatedName, " был исключен с ", maxVotes, " голосами.\n");
+        recordEvent(EventPhase::Day, EventAction::Execute, NoPlayer, eliminatedPlayer, maxVotes);
+    } else {
+        logger.add(LogSink::Day, LogLevel::Summary, "\nНикто не был исключен.\n");
+    }
+
+    logger.add(LogSink::Day, LogLevel::Summary, '\n');
+    logger.commit(LogSink::Day, currentDay);
+
+    console.print(Verbosity::Summary, "**************************************\n");
+    MAFIA_TIME_SECTION(MetricSection::Output);
+    console.flush();
+}
+
+
+
+};
+
+#endif // GAME_H
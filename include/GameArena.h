@@ -0,0 +1,41 @@
+#ifndef GAMEARENA_H
+#define GAMEARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+// память одной игры. Игроки, стратегии и их блоки счетчиков берутся из game(),
+// временные контейнеры фазы — из phase(). Оба буфера монотонные: delete ничего не делает,
+// а память возвращается целиком через resetPhase() и reset().
+// буферы выделяются один раз и переиспользуются между играми; если игре их не хватит,
+// монотонный ресурс доберет память из кучи и отдаст ее при reset()
+class GameArena {
+public:
+    explicit GameArena(size_t gameBytes = 64 * 1024, size_t phaseBytes = 16 * 1024)
+        : gameBuffer(new std::byte[gameBytes]), phaseBuffer(new std::byte[phaseBytes]),
+          gameResource(gameBuffer.get(), gameBytes), phaseResource(phaseBuffer.get(), phaseBytes) {}
+
+    GameArena(const GameArena&) = delete;
+    GameArena& operator=(const GameArena&) = delete;
+
+    std::pmr::memory_resource* game() { return &gameResource; }
+    std::pmr::memory_resource* phase() { return &phaseResource; }
+
+    // в начале каждой фазы; контейнеры прошлой фазы к этому моменту уже уничтожены
+    void resetPhase() { phaseResource.release(); }
+
+    // между играми; все объекты прошлой игры к этому моменту уже уничтожены
+    void reset() {
+        phaseResource.release();
+        gameResource.release();
+    }
+
+private:
+    std::unique_ptr<std::byte[]> gameBuffer;
+    std::unique_ptr<std::byte[]> phaseBuffer;
+    std::pmr::monotonic_buffer_resource gameResource;
+    std::pmr::monotonic_buffer_resource phaseResource;
+};
+
+#endif // GAMEARENA_H
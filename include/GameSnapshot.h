@@ -0,0 +1,297 @@
+#ifndef GAMESNAPSHOT_H
+#define GAMESNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "MySharedPtr.h"
+#include "EventLog.h"
+#include "Roles.h"
+
+// снимок партии между фазами: из него игру можно продолжить (после падения) или
+// развести на много продолжений с разными сидами, не переигрывая с первого дня.
+// номера игроков — те же PlayerId, что в GameMaster
+
+constexpr std::uint32_t SnapshotMagic = 0x5346414D;  // "MAFS"
+constexpr std::uint16_t SnapshotVersion = 4;  // 2: длина имени — uint32, 3: записи журнала событий по 20 байт, 4: DeathReveal
+constexpr std::int32_t SnapshotMinPlayers = 5;  // меньше игра не начинается
+
+// то, что у игрока меняется по ходу игры
+struct PlayerState {
+    bool alive = true;
+    DeathReveal deathReveal = DeathReveal::None;
+    std::int32_t lastHealed = -1;                              // доктор
+    std::vector<std::pair<std::int32_t, bool>> checkedPlayers;  // комиссар: id и «мафия», по возрастанию id
+
+    bool operator==(const PlayerState&) const = default;
+};
+
+struct PlayerRecord {
+    std::int32_t id;
+    Role role;
+    std::string name;
+    PlayerState state;
+};
+
+// записи игроков неизменяемые и общие: копия снимка копирует указатели, а снимки одной игры подряд
+// делят записи тех, у кого ничего не поменялось. Счетчик атомарный — снимок можно отдавать другим потокам
+struct GameSnapshot {
+    std::uint64_t seed = 0;
+    std::int32_t numPlayers = 0;
+    bool isUserPlayer = false;  // человек — игрок 0
+    std::int32_t currentDay = 1;
+    bool nightNext = false;     // снимок сделан после дня, дальше ночь
+    std::uint8_t winner = 0;    // Winner
+    std::mt19937 rng;           // генератор игры
+    std::vector<MyAtomicSharedPtr<const PlayerRecord>> players;
+    std::vector<std::uint64_t> playerRngs;  // генератор стратегии каждого игрока
+    std::vector<std::int32_t> playersToReveal;
+    std::vector<std::int32_t> healedPlayers;
+    std::vector<EventRecord> events;
+};
+
+// запись фиксированных полей подряд, в порядке байт машины, как в журнале событий
+class SnapshotWriter {
+public:
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        data.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void putBytes(const void* bytes, size_t size) {
+        data.append(static_cast<const char*>(bytes), size);
+    }
+
+    std::string take() { return std::move(data); }
+
+private:
+    std::string data;
+};
+
+// чтение с проверкой границ: после первой ошибки все get возвращают false
+class SnapshotReader {
+public:
+    explicit SnapshotReader(std::string_view data) : data(data) {}
+
+    template <typename T>
+    bool get(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        return getBytes(&value, sizeof(value));
+    }
+
+    bool getBytes(void* bytes, size_t size) {
+        if (failed || data.size() - pos < size) {
+            failed = true;
+            return false;
+        }
+        if (size == 0) {
+            return true;  // у пустого вектора data() может быть nullptr, а memcpy его не принимает
+        }
+        std::memcpy(bytes, data.data() + pos, size);
+        pos += size;
+        return true;
+    }
+
+    // счетчик элементов, который не может быть больше оставшихся байт
+    bool getCount(std::uint32_t& count, size_t elementSize) {
+        if (!get(count)) {
+            return false;
+        }
+        if (static_cast<size_t>(count) * elementSize > data.size() - pos) {
+            failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    bool atEnd() const { return !failed && pos == data.size(); }
+
+private:
+    std::string_view data;
+    size_t pos = 0;
+    bool failed = false;
+};
+
+// текстовое состояние mt19937 — это его слова через пробел, в файл они идут как uint32
+inline void putEngine(SnapshotWriter& out, const std::mt19937& rng) {
+    std::ostringstream text;
+    text << rng;
+    std::istringstream words(text.str());
+    std::vector<std::uint32_t> state{std::istream_iterator<std::uint32_t>(words), std::istream_iterator<std::uint32_t>()};
+    out.put(static_cast<std::uint32_t>(state.size()));
+    out.putBytes(state.data(), state.size() * sizeof(std::uint32_t));
+}
+
+inline bool getEngine(SnapshotReader& in, std::mt19937& rng) {
+    std::uint32_t count = 0;
+    if (!in.getCount(count, sizeof(std::uint32_t))) {
+        return false;
+    }
+    std::vector<std::uint32_t> state(count);
+    if (!in.getBytes(state.data(), state.size() * sizeof(std::uint32_t))) {
+        return false;
+    }
+    std::ostringstream text;
+    for (std::uint32_t word : state) {
+        text << word << ' ';
+    }
+    std::istringstream words(text.str());
+    return static_cast<bool>(words >> rng);
+}
+
+template <typename T>
+void putVector(SnapshotWriter& out, const std::vector<T>& values) {
+    out.put(static_cast<std::uint32_t>(values.size()));
+    out.putBytes(values.data(), values.size() * sizeof(T));
+}
+
+template <typename T>
+bool getVector(SnapshotReader& in, std::vector<T>& values) {
+    std::uint32_t count = 0;
+    if (!in.getCount(count, sizeof(T))) {
+        return false;
+    }
+    values.resize(count);
+    return in.getBytes(values.data(), values.size() * sizeof(T));
+}
+
+// 50 игроков в середине игры — около 5 КБ, из них 2.5 КБ — генератор игры
+inline std::string encodeSnapshot(const GameSnapshot& snapshot) {
+    SnapshotWriter out;
+    out.put(SnapshotMagic);
+    out.put(SnapshotVersion);
+    out.put(static_cast<std::uint8_t>(snapshot.isUserPlayer | (snapshot.nightNext << 1)));
+    out.put(snapshot.winner);
+    out.put(snapshot.seed);
+    out.put(snapshot.numPlayers);
+    out.put(snapshot.currentDay);
+    putEngine(out, snapshot.rng);
+
+    out.put(static_cast<std::uint32_t>(snapshot.players.size()));
+    for (const auto& record : snapshot.players) {
+        out.put(record->id);
+        out.put(record->role);
+        out.put(static_cast<std::uint8_t>(record->state.alive));
+        out.put(record->state.deathReveal);
+        out.put(static_cast<std::uint32_t>(record->name.size()));
+        out.putBytes(record->name.data(), record->name.size());
+        out.put(record->state.lastHealed);
+        out.put(static_cast<std::uint32_t>(record->state.checkedPlayers.size()));
+        for (const auto& [id, isMafia] : record->state.checkedPlayers) {
+            out.put(id);
+            out.put(static_cast<std::uint8_t>(isMafia));
+        }
+    }
+    putVector(out, snapshot.playerRngs);
+    putVector(out, snapshot.playersToReveal);
+    putVector(out, snapshot.healedPlayers);
+    putVector(out, snapshot.events);
+    return out.take();
+}
+
+// номер игрока из снимка; GameMaster индексирует по нему игроков, так что чужие номера не пропускаем
+inline bool validPlayerId(std::int32_t id, std::int32_t numPlayers, bool allowNone = false) {
+    return (id >= 0 && id < numPlayers) || (allowNone && id == -1);
+}
+
+inline bool validPlayerIds(const std::vector<std::int32_t>& ids, std::int32_t numPlayers) {
+    for (std::int32_t id : ids) {
+        if (!validPlayerId(id, numPlayers)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// false — данные повреждены, другой версии или с номерами игроков вне игры; snapshot тогда не трогается
+inline bool decodeSnapshot(std::string_view data, GameSnapshot& snapshot) {
+    SnapshotReader in(data);
+    GameSnapshot result;
+    std::uint32_t magic = 0;
+    std::uint16_t version = 0;
+    std::uint8_t flags = 0;
+    if (!in.get(magic) || magic != SnapshotMagic || !in.get(version) || version != SnapshotVersion || !in.get(flags) ||
+        !in.get(result.winner) || !in.get(result.seed) || !in.get(result.numPlayers) || !in.get(result.currentDay) ||
+        !getEngine(in, result.rng) || result.numPlayers < SnapshotMinPlayers) {
+        return false;
+    }
+    result.isUserPlayer = flags & 1;
+    result.nightNext = flags & 2;
+
+    std::uint32_t numRecords = 0;
+    if (!in.getCount(numRecords, sizeof(std::int32_t)) || numRecords != static_cast<std::uint32_t>(result.numPlayers)) {
+        return false;
+    }
+    result.players.reserve(numRecords);
+    for (std::uint32_t i = 0; i < numRecords; ++i) {
+        PlayerRecord record;
+        std::uint8_t alive = 0;
+        std::uint32_t nameSize = 0;
+        std::uint32_t numChecked = 0;
+        if (!in.get(record.id) || record.id != static_cast<std::int32_t>(i) || !in.get(record.role) ||
+            static_cast<size_t>(record.role) >= RoleCount || !in.get(alive) || !in.get(record.state.deathReveal) ||
+            static_cast<size_t>(record.state.deathReveal) >= DeathRevealCount ||
+            (alive != 0) != (record.state.deathReveal == DeathReveal::None) || !in.getCount(nameSize, 1)) {
+            return false;
+        }
+        record.name.resize(nameSize);
+        if (!in.getBytes(record.name.data(), nameSize) || !in.get(record.state.lastHealed) ||
+            !validPlayerId(record.state.lastHealed, result.numPlayers, true) || !in.getCount(numChecked, sizeof(std::int32_t) + 1)) {
+            return false;
+        }
+        record.state.alive = alive != 0;
+        record.state.checkedPlayers.resize(numChecked);
+        for (auto& [id, isMafia] : record.state.checkedPlayers) {
+            std::uint8_t mafia = 0;
+            if (!in.get(id) || !validPlayerId(id, result.numPlayers) || !in.get(mafia)) {
+                return false;
+            }
+            isMafia = mafia != 0;
+        }
+        result.players.push_back(make_my_atomic_shared<PlayerRecord>(std::move(record)));
+    }
+
+    if (!getVector(in, result.playerRngs) || result.playerRngs.size() != numRecords || !getVector(in, result.playersToReveal) ||
+        !getVector(in, result.healedPlayers) || !getVector(in, result.events) || !in.atEnd() ||
+        !validPlayerIds(result.playersToReveal, result.numPlayers) || !validPlayerIds(result.healedPlayers, result.numPlayers)) {
+        return false;
+    }
+    snapshot = std::move(result);
+    return true;
+}
+
+// пишет во временный файл и переименовывает, так что на диске всегда целый снимок
+inline bool saveSnapshot(const std::string& path, const GameSnapshot& snapshot) {
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        std::string data = encodeSnapshot(snapshot);
+        if (!out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            return false;
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+inline bool loadSnapshot(const std::string& path, GameSnapshot& snapshot) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    std::string data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    return decodeSnapshot(data, snapshot);
+}
+
+#endif // GAMESNAPSHOT_H
@@ -0,0 +1,99 @@
+#ifndef GAMESTATE_H
+#define GAMESTATE_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "Roles.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// плотное состояние игроков рядом с объектами Player: бит «жив», байт роли и бит стороны.
+// номер игрока тот же, что в GameMaster::players. Подсчеты и обходы живых — это AND масок
+// и popcount по словам, без обращения к объектам; 10 000 игроков — около 20 кэш-линий на маску
+class GameState {
+public:
+    using Word = std::uint64_t;
+    static constexpr size_t WordBits = 64;
+
+    // число игроков известно заранее, все маски лежат одним куском: сначала «жив», потом по маске на сторону
+    GameState(size_t capacity, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : words((capacity + WordBits - 1) / WordBits), masks(words * (1 + FactionCount), 0, resource),
+          roles(capacity, Role::Civilian, resource) {}
+
+    void addPlayer(int id, Role role) {
+        roles[id] = role;
+        setBit(aliveMask(), id);
+        setBit(factionMask(roleTraits(role).faction), id);
+    }
+
+    void kill(int id) {
+        aliveMask()[id / WordBits] &= ~bit(id);
+    }
+
+    bool isAlive(int id) const { return (aliveMask()[id / WordBits] & bit(id)) != 0; }
+    Role role(int id) const { return roles[id]; }
+
+    int countAlive() const {
+        return andPopcount(aliveMask(), aliveMask(), words);
+    }
+
+    int countAlive(Faction faction) const {
+        return andPopcount(aliveMask(), factionMask(faction), words);
+    }
+
+    // живые по возрастанию номера, как в GameMaster::players
+    template <typename Fn>
+    void forEachAlive(Fn&& fn) const {
+        const Word* alive = aliveMask();
+        for (size_t w = 0; w < words; ++w) {
+            for (Word bits = alive[w]; bits != 0; bits &= bits - 1) {
+                fn(static_cast<int>(w * WordBits + std::countr_zero(bits)));
+            }
+        }
+    }
+
+private:
+    size_t words;
+    std::pmr::vector<Word> masks;
+    std::pmr::vector<Role> roles;
+
+    Word* aliveMask() { return masks.data(); }
+    const Word* aliveMask() const { return masks.data(); }
+    Word* factionMask(Faction faction) { return masks.data() + words * (1 + static_cast<size_t>(faction)); }
+    const Word* factionMask(Faction faction) const { return masks.data() + words * (1 + static_cast<size_t>(faction)); }
+
+    static Word bit(int id) { return Word{1} << (id % WordBits); }
+    static void setBit(Word* mask, int id) { mask[id / WordBits] |= bit(id); }
+
+    // popcount(a & b) по n словам; с AVX2 — по 4 слова за шаг через таблицу popcount полубайтов
+    static int andPopcount(const Word* a, const Word* b, size_t n) {
+        size_t i = 0;
+        std::uint64_t total = 0;
+#ifdef __AVX2__
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+        __m256i sums = _mm256_setzero_si256();
+        for (; i + 4 <= n; i += 4) {
+            __m256i v = _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                         _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+            __m256i lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, lowNibble));
+            __m256i hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble));
+            sums = _mm256_add_epi64(sums, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+        }
+        total += static_cast<std::uint64_t>(_mm256_extract_epi64(sums, 0)) + static_cast<std::uint64_t>(_mm256_extract_epi64(sums, 1)) +
+                 static_cast<std::uint64_t>(_mm256_extract_epi64(sums, 2)) + static_cast<std::uint64_t>(_mm256_extract_epi64(sums, 3));
+#endif
+        for (; i < n; ++i) {
+            total += std::popcount(a[i] & b[i]);
+        }
+        return static_cast<int>(total);
+    }
+};
+
+#endif // GAMESTATE_H
@@ -1,32 +1,342 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <filesystem>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <unordered_map>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include "Metrics.h"
+#include "TextFormat.h"
+
+struct LogRecord {
+    std::string path;
+    std::string text;
+};
+
+// ограниченная lock-free очередь (схема Вьюкова): много писателей, один читатель.
+// вместимость округляется вверх до степени двойки
+template <typename T>
+class BoundedLogQueue {
+public:
+    explicit BoundedLogQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(T&& value) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // очередь заполнена
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::ptrdiff_t>(seq) - static_cast<std::ptrdiff_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.data);
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // очередь пуста
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+};
+
+struct LogWriterOptions {
+    size_t queueCapacity = 8192;
+    size_t flushEveryRecords = 512;  // 0 — сбрасывать только по таймеру и при завершении
+    std::chrono::milliseconds flushInterval{100};
+    size_t maxOpenFiles = 64;
+};
+
+// фоновый писатель логов: держит файлы открытыми, забирает записи пачками и сбрасывает их на диск.
+// игровые потоки только кладут записи в очередь и никогда не ждут диска
+class AsyncLogWriter {
+public:
+    using Options = LogWriterOptions;
+
+    explicit AsyncLogWriter(const Options& options = Options())
+        : options(options), queue(options.queueCapacity), writerThread([this] { run(); }) {}
+
+    ~AsyncLogWriter() {
+        stopping.store(true, std::memory_order_release);
+        writerThread.join();
+    }
+
+    AsyncLogWriter(const AsyncLogWriter&) = delete;
+    AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+    void write(std::string path, std::string text) {
+        LogRecord record{std::move(path), std::move(text)};
+        // если писатель не успевает, ждем места в очереди, а не диска
+        while (!queue.tryPush(std::move(record))) {
+            std::this_thread::yield();
+        }
+    }
+
+    // общий писатель процесса; параметры нужно задать до первого обращения
+    static AsyncLogWriter& shared() {
+        static AsyncLogWriter writer(sharedOptions());
+        return writer;
+    }
+
+    static Options& sharedOptions() {
+        static Options options;
+        return options;
+    }
+
+private:
+    Options options;
+    BoundedLogQueue<LogRecord> queue;
+    std::atomic<bool> stopping{false};
+    std::unordered_map<std::string, std::ofstream> files;
+    std::thread writerThread;
+
+    void run() {
+        using clock = std::chrono::steady_clock;
+        LogRecord record;
+        size_t unflushed = 0;
+        auto lastFlush = clock::now();
+
+        for (;;) {
+            // флаг читаем до разбора очереди: если он уже выставлен, все записи до остановки видны
+            bool stop = stopping.load(std::memory_order_acquire);
+            size_t popped = 0;
+
+            // за один проход забираем пачку, чтобы не проверять часы на каждой записи
+            while (popped < 256 && queue.tryPop(record)) {
+                ++popped;
+                fileFor(record.path) << record.text;
+                if (++unflushed == options.flushEveryRecords) {
+                    flushAll();
+                    unflushed = 0;
+                    lastFlush = clock::now();
+                }
+            }
+
+            if (unflushed > 0 && clock::now() - lastFlush >= options.flushInterval) {
+                flushAll();
+                unflushed = 0;
+                lastFlush = clock::now();
+            }
+
+            if (popped == 0) {
+                if (stop) {
+                    break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        flushAll();
+        files.clear();
+    }
+
+    std::ofstream& fileFor(const std::string& path) {
+        auto it = files.find(path);
+        if (it != files.end()) {
+            return it->second;
+        }
+        if (files.size() >= options.maxOpenFiles) {
+            flushAll();
+            files.clear();
+        }
+        return files.emplace(path, std::ofstream(path, std::ios::app | std::ios::binary)).first->second;
+    }
+
+    void flushAll() {
+        for (auto& [path, file] : files) {
+            file.flush();
+        }
+    }
+};
+
+// лог игры: файл дня, файл ночи и итоги игры
+enum class LogSink : std::uint8_t {
+    Day,
+    Night,
+    Result
+};
+
+constexpr size_t LogSinkCount = 3;
+
+// Summary — итоги: сид, казни, убийства, лечение, проверка, победитель.
+// Detail — еще каждый голос, каждое ночное действие, роли и состояние всех игроков
+enum class LogLevel : std::uint8_t {
+    Off,
+    Summary,
+    Detail
+};
+
+struct LoggerOptions {
+    std::array<LogLevel, LogSinkCount> levels{LogLevel::Detail, LogLevel::Detail, LogLevel::Detail};
+};
+
+// "off", "summary", "detail" для всех логов или по логам: "day=detail,night=off,result=summary".
+// false — не разобрали, options тогда не меняются
+inline bool parseLogLevels(std::string_view spec, LoggerOptions& options) {
+    constexpr std::string_view levelKeys[] = {"off", "summary", "detail"};
+    constexpr std::string_view sinkKeys[] = {"day", "night", "result"};
+    auto levelFromKey = [&](std::string_view key, LogLevel& level) {
+        for (size_t i = 0; i < std::size(levelKeys); ++i) {
+            if (key == levelKeys[i]) {
+                level = static_cast<LogLevel>(i);
+                return true;
+            }
+        }
+        return false;
+    };
 
+    LoggerOptions parsed = options;
+    if (spec.find('=') == std::string_view::npos) {
+        LogLevel level;
+        if (!levelFromKey(spec, level)) {
+            return false;
+        }
+        parsed.levels.fill(level);
+        options = parsed;
+        return true;
+    }
+    while (!spec.empty()) {
+        size_t comma = spec.find(',');
+        std::string_view item = spec.substr(0, comma);
+        spec = comma == std::string_view::npos ? std::string_view() : spec.substr(comma + 1);
+        size_t equals = item.find('=');
+        if (equals == std::string_view::npos) {
+            return false;
+        }
+        size_t sink = 0;
+        while (sink < LogSinkCount && item.substr(0, equals) != sinkKeys[sink]) {
+            ++sink;
+        }
+        if (sink == LogSinkCount || !levelFromKey(item.substr(equals + 1), parsed.levels[sink])) {
+            return false;
+        }
+    }
+    options = parsed;
+    return true;
+}
+
+// записи лога собираются по полям: строки, символы и целые копятся в буфере своего лога
+// и превращаются в текст, только если этот лог пишет такой уровень. Иначе add — одна проверка.
+// commit отдает накопленное за фазу фоновому писателю одной записью
 class Logger {
 public:
-    Logger() {
-        createLogDirectory();
+    using Options = LoggerOptions;
+
+    // уровни берутся из sharedOptions; выключенный логгер ничего не пишет. Параметры нужно задать до создания
+    explicit Logger(bool enabled = true) {
+        if (enabled) {
+            levels = sharedOptions().levels;
+        } else {
+            levels.fill(LogLevel::Off);
+        }
+        if (isEnabled()) {
+            createLogDirectory();
+        }
     }
 
-    void logDayAction(int day, const std::string& action) {
-        std::ofstream file(logDir + "/day_" + std::to_string(day) + ".txt", std::ios::app);
-        file << action << std::endl;
+    static Options& sharedOptions() {
+        static Options options;
+        return options;
     }
 
-    void logNightAction(int day, const std::string& action) {
-        std::ofstream file(logDir + "/night_" + std::to_string(day) + ".txt", std::ios::app);
-        file << action << std::endl;
+    // пишет ли хоть один лог
+    bool isEnabled() const {
+        for (LogLevel level : levels) {
+            if (level != LogLevel::Off) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool isEnabled(LogSink sink, LogLevel level) const {
+        return level <= levels[static_cast<size_t>(sink)] && level != LogLevel::Off;
+    }
+
+    template <typename... Fields>
+    void add(LogSink sink, LogLevel level, const Fields&... fields) {
+        if (!isEnabled(sink, level)) {
+            return;
+        }
+        appendParts(pending[static_cast<size_t>(sink)], fields...);
     }
 
-    void logResult(const std::string& result) {
-        std::ofstream file(logDir + "/results.txt", std::ios::app);
-        file << result << std::endl;
+    // накопленное в sink уходит в файл дня или ночи day (для итогов day не важен). Буфер остается
+    // со своей емкостью, так что следующая фаза собирается без новых выделений
+    void commit(LogSink sink, int day) {
+        std::string& text = pending[static_cast<size_t>(sink)];
+        if (text.empty()) return;
+        MAFIA_TIME_SECTION(MetricSection::Log);
+        MAFIA_COUNT(MetricCounter::LogRecords, 1);
+        AsyncLogWriter::shared().write(pathFor(sink, day), text);
+        text.clear();
     }
 
 private:
+    std::array<LogLevel, LogSinkCount> levels;  // в пакетной симуляции все Off
+    std::array<std::string, LogSinkCount> pending;
     const std::string logDir = "../logs"; // так как запускаем игру из build
 
+    std::string pathFor(LogSink sink, int day) const {
+        switch (sink) {
+            case LogSink::Day: return logDir + "/day_" + std::to_string(day) + ".txt";
+            case LogSink::Night: return logDir + "/night_" + std::to_string(day) + ".txt";
+            case LogSink::Result: break;
+        }
+        return logDir + "/results.txt";
+    }
+
     void createLogDirectory() {
         std::filesystem::path dirPath(logDir);
         if (!std::filesystem::exists(dirPath)) {
@@ -34,3 +344,5 @@ private:
         }
     }
 };
+
+#endif // LOGGER_H
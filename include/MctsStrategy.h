@@ -0,0 +1,631 @@
+#ifndef MCTSSTRATEGY_H
+#define MCTSSTRATEGY_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cppcoro/static_thread_pool.hpp>
+#include <cppcoro/task.hpp>
+#include "Game.h"
+
+// стратегия с поиском Монте-Карло. Для каждого решения бот много раз доигрывает партию до конца:
+// роли, которых он не знает, каждый раз разыгрываются заново так, чтобы не противоречить его знанию,
+// его ход фиксирован, а остальные ходы случайные, как у BotStrategy. Ход выбирается по UCB1 на корне.
+// Доигрывания идут на отдельном пуле независимыми деревьями, их статистика потом складывается
+
+struct MctsOptions {
+    int rollouts = 256;                        // доигрываний на решение; 0 — только по времени
+    std::chrono::microseconds timeBudget{0};   // время на решение; 0 — без ограничения
+    int trees = 8;                             // независимых деревьев корня; от числа потоков не зависит
+    int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));  // потоков пула
+    double exploration = 1.4;                  // константа UCB1
+    size_t maxCandidates = 16;                 // целей больше — берется случайная выборка
+};
+
+enum class RolloutAction : std::uint8_t { Vote, Kill, Heal, Check };
+
+// ход, который проверяет поиск: кто, что и с кем
+struct RolloutMove {
+    PlayerId actor = NoPlayer;
+    RolloutAction action = RolloutAction::Vote;
+    PlayerId target = NoPlayer;
+};
+
+// партия в доигрывании: роли, живые и доктор. Копия — несколько векторов, а присваивание
+// в уже созданное состояние не выделяет память, так что доигрывания переиспользуют одно
+class RolloutState {
+public:
+    std::vector<Role> roles;      // по id
+    std::vector<PlayerId> alive;  // живые в любом порядке
+    std::vector<int> slot;        // место игрока в alive, -1 — мертв
+    std::array<int, FactionCount> aliveByFaction{};
+    PlayerId lastHealed = NoPlayer;
+    std::vector<std::uint8_t> cleared;  // комиссар проверил и мафии не увидел; против них он не голосует и не действует
+
+    void reset(size_t numPlayers) {
+        roles.assign(numPlayers, Role::Civilian);
+        alive.clear();
+        slot.assign(numPlayers, -1);
+        aliveByFaction.fill(0);
+        lastHealed = NoPlayer;
+        cleared.assign(numPlayers, 0);
+    }
+
+    // роли живых задаются отдельно (setRole), поэтому стороны считаются в countFactions
+    void addAlive(PlayerId id) {
+        slot[id] = static_cast<int>(alive.size());
+        alive.push_back(id);
+    }
+
+    void setRole(PlayerId id, Role role) { roles[id] = role; }
+
+    void countFactions() {
+        aliveByFaction.fill(0);
+        for (PlayerId id : alive) {
+            ++aliveByFaction[static_cast<size_t>(faction(id))];
+        }
+    }
+
+    bool isAlive(PlayerId id) const { return slot[id] >= 0; }
+    Faction faction(PlayerId id) const { return roleTraits(roles[id]).faction; }
+
+    void kill(PlayerId id) {
+        int position = slot[id];
+        if (position < 0) {
+            return;
+        }
+        PlayerId last = alive.back();
+        alive[position] = last;
+        slot[last] = position;
+        alive.pop_back();
+        slot[id] = -1;
+        --aliveByFaction[static_cast<size_t>(faction(id))];
+    }
+
+    // та же проверка, что в GameMaster::isGameOver; пусто — игра продолжается
+    std::optional<Faction> winner() const {
+        int mafia = aliveByFaction[static_cast<size_t>(Faction::Mafia)];
+        int civilians = aliveByFaction[static_cast<size_t>(Faction::Civilians)];
+        int maniac = aliveByFaction[static_cast<size_t>(Faction::Maniac)];
+        if (mafia > civilians || (mafia == civilians && maniac == 0)) {
+            return Faction::Mafia;
+        }
+        if (mafia == 0 && maniac == 0) {
+            return Faction::Civilians;
+        }
+        if (maniac == 1 && mafia == 0 && civilians <= 1) {
+            return Faction::Maniac;
+        }
+        return std::nullopt;
+    }
+
+    // живой игрок, для которого accept верно: как BotStrategy::pickTarget, но только среди живых
+    template <typename Accept>
+    PlayerId pickAlive(SplitMix64& rng, Accept&& accept) const {
+        if (alive.empty()) {
+            return NoPlayer;
+        }
+        std::uniform_int_distribution<size_t> anyAlive(0, alive.size() - 1);
+        for (int attempt = 0; attempt < 8; ++attempt) {
+            PlayerId candidate = alive[anyAlive(rng)];
+            if (accept(candidate)) {
+                return candidate;
+            }
+        }
+        PlayerId chosen = NoPlayer;
+        std::uint64_t seen = 0;
+        for (PlayerId candidate : alive) {
+            if (accept(candidate) && std::uniform_int_distribution<std::uint64_t>(0, seen++)(rng) == 0) {
+                chosen = candidate;
+            }
+        }
+        return chosen;
+    }
+
+    // день по правилам playDayPhase; votes — рабочий массив по числу игроков, из нулей и остается из нулей
+    void playDay(SplitMix64& rng, const RolloutMove* fixed, std::vector<int>& votes) {
+        int best = 0;
+        size_t tied = 0;
+        for (size_t i = 0; i < alive.size(); ++i) {
+            PlayerId voter = alive[i];
+            PlayerId target = fixed && fixed->actor == voter ? fixed->target : pickAlive(rng, [&](PlayerId candidate) {
+                return candidate != voter && !(faction(voter) == Faction::Mafia && faction(candidate) == Faction::Mafia) &&
+                       !(roles[voter] == Role::Commissar && cleared[candidate]);
+            });
+            if (target == NoPlayer) {
+                continue;
+            }
+            int count = ++votes[target];
+            if (count > best) {
+                best = count;
+                tied = 1;
+            } else if (count == best) {
+                ++tied;
+            }
+        }
+        PlayerId executed = pickLeader(rng, votes, best, tied);
+        if (executed != NoPlayer) {
+            kill(executed);
+        }
+    }
+
+    // ночь по правилам playNightPhase
+    void playNight(SplitMix64& rng, const RolloutMove* fixed, std::vector<int>& votes) {
+        std::array<PlayerId, KillPriorityCount> victims;
+        victims.fill(NoPlayer);
+        PlayerId heal = NoPlayer;
+        int best = 0;
+        size_t tied = 0;
+
+        for (size_t i = 0; i < alive.size(); ++i) {
+            PlayerId actor = alive[i];
+            const RoleTraits& traits = roleTraits(roles[actor]);
+            RolloutMove move{actor, RolloutAction::Kill, NoPlayer};
+            if (fixed && fixed->actor == actor) {
+                move = *fixed;
+            } else if (traits.faction == Faction::Mafia) {
+                move.target = pickAlive(rng, [&](PlayerId candidate) { return faction(candidate) != Faction::Mafia; });
+            } else if (roles[actor] == Role::Maniac) {
+                move.target = pickAlive(rng, [&](PlayerId candidate) { return candidate != actor; });
+            } else if (roles[actor] == Role::Commissar) {
+                move.action = std::uniform_int_distribution<int>(0, 1)(rng) == 0 ? RolloutAction::Check : RolloutAction::Kill;
+                move.target = pickAlive(rng, [&](PlayerId candidate) { return candidate != actor && !cleared[candidate]; });
+            } else if (roles[actor] == Role::Doctor) {
+                move.action = RolloutAction::Heal;
+                move.target = pickAlive(rng, [&](PlayerId candidate) { return candidate != lastHealed; });
+            } else {
+                continue;
+            }
+            if (move.target == NoPlayer) {
+                continue;
+            }
+
+            if (move.action == RolloutAction::Heal) {
+                heal = move.target;
+                lastHealed = move.target;
+            } else if (move.action == RolloutAction::Check) {
+                if (!roleTraits(roles[move.target]).visibleToCommissar) {
+                    cleared[move.target] = 1;
+                }
+            } else if (move.action == RolloutAction::Kill) {
+                if (traits.joinsMafiaVote) {
+                    int count = ++votes[move.target];
+                    if (count > best) {
+                        best = count;
+                        tied = 1;
+                    } else if (count == best) {
+                        ++tied;
+                    }
+                } else if (traits.killPriority != NoKill &&
+                           !(killRules[traits.killPriority].stoppedByImmunity && roleTraits(roles[move.target]).immuneToManiac)) {
+                    victims[traits.killPriority] = move.target;
+                }
+            }
+        }
+        victims[MafiaKillPriority] = pickLeader(rng, votes, best, tied);
+
+        for (PlayerId victim : victims) {
+            if (victim != NoPlayer && victim != heal) {
+                kill(victim);
+            }
+        }
+    }
+
+private:
+    // лидер голосования с равновероятным выбором при ничьей, как VoteTally::leader. Обнуляет votes у живых;
+    // голоса бывают только за живых, так что массив снова весь из нулей
+    PlayerId pickLeader(SplitMix64& rng, std::vector<int>& votes, int best, size_t tied) const {
+        PlayerId leader = NoPlayer;
+        if (best > 0) {
+            size_t pick = tied > 1 ? std::uniform_int_distribution<size_t>(0, tied - 1)(rng) : 0;
+            // порядок alive одинаков при одном и том же сиде, так что выбор повторяется
+            for (PlayerId id : alive) {
+                if (votes[id] == best && leader == NoPlayer && pick-- == 0) {
+                    leader = id;
+                }
+            }
+        }
+        for (PlayerId id : alive) {
+            votes[id] = 0;
+        }
+        return leader;
+    }
+};
+
+// допустимые роли, по биту на роль
+using RoleMask = std::uint8_t;
+static_assert(RoleCount <= 8, "маска ролей — один байт");
+
+constexpr RoleMask roleMaskWhere(bool (*test)(const RoleTraits&)) {
+    RoleMask mask = 0;
+    for (size_t role = 0; role < RoleCount; ++role) {
+        if (test(roleTraitsTable[role])) {
+            mask |= static_cast<RoleMask>(1u << role);
+        }
+    }
+    return mask;
+}
+
+// что бот знает о партии: живых, свою роль, союзников-мафию, проверки комиссара и то, что вскрыли смерти
+// (см. DeathReveal): у казненных — только «мафия или нет», у убитых ночью — роль без подвида мафии.
+// Роль, которую знание определяет целиком, закрепляется за игроком и уходит из состава; остальные роли
+// живых и мертвых незнакомцев разыгрываются для каждого доигрывания заново
+class RoleSampler {
+public:
+    RoleSampler(const std::vector<MySharedPtr<Player>>& players, PlayerId self) {
+        size_t numPlayers = players.size();
+        base.reset(numPlayers);
+        const Player& me = *players[self];
+        faction = me.getFaction();
+
+        // состав как в GameMaster::assignRoles: пятая часть мафии, по одному доктору, комиссару и маньяку
+        int mafiaSlots = std::max(1, static_cast<int>(numPlayers) / 5);
+        std::array<int, RoleCount> remaining{};
+        remaining[static_cast<size_t>(Role::Doctor)] = 1;
+        remaining[static_cast<size_t>(Role::Commissar)] = 1;
+        remaining[static_cast<size_t>(Role::Maniac)] = 1;
+        remaining[static_cast<size_t>(Role::Civilian)] = static_cast<int>(numPlayers) - mafiaSlots - 3;
+        std::array<bool, RoleCount> seen{};
+
+        const std::pmr::unordered_map<PlayerId, bool>* checks = nullptr;
+        if (me.getRole() == Role::Commissar) {
+            checks = &static_cast<const Commissar&>(me).getCheckedPlayers();
+        }
+
+        if (checks) {
+            for (const auto& [id, isMafia] : *checks) {
+                if (!isMafia) {
+                    base.cleared[id] = 1;
+                }
+            }
+        }
+
+        for (const auto& player : players) {
+            PlayerId id = player->getId();
+            if (player->isAlive()) {
+                base.addAlive(id);
+            }
+            RoleMask allowed = AnyRole;
+            // роль известна: своя или союзника по мафии
+            if (id == self || (faction == Faction::Mafia && player->getFaction() == Faction::Mafia)) {
+                allowed = roleBit(player->getRole());
+            }
+            allowed &= revealedRoles(*player);
+            if (checks) {
+                auto it = checks->find(id);
+                if (it != checks->end()) {
+                    allowed &= it->second ? VisibleRoles : static_cast<RoleMask>(~VisibleRoles);
+                }
+            }
+            if (!std::has_single_bit(allowed)) {
+                unknown.push_back({id, allowed});
+                continue;
+            }
+            Role role = static_cast<Role>(std::countr_zero(allowed));
+            base.setRole(id, role);
+            seen[static_cast<size_t>(role)] = true;
+            if (isMafiaRole(role)) {
+                --mafiaSlots;
+            } else {
+                --remaining[static_cast<size_t>(role)];
+            }
+        }
+
+        for (size_t role = 0; role < RoleCount; ++role) {
+            if (!isMafiaRole(static_cast<Role>(role))) {
+                pool.insert(pool.end(), std::max(0, remaining[role]), static_cast<Role>(role));
+            }
+        }
+        // подвиды мафии игра раздает случайно и не больше одного каждого; неизвестные слоты мафии
+        // в каждом доигрывании получают еще не виденные подвиды в случайном порядке, остальные — обычная мафия
+        for (Role subtype : {Role::Bull, Role::Ninja, Role::Killer}) {
+            if (!seen[static_cast<size_t>(subtype)]) {
+                subtypes.push_back(subtype);
+            }
+        }
+        mafiaUnknown = std::max(0, mafiaSlots);
+    }
+
+    Faction ownFaction() const { return faction; }
+
+    // роли неизвестных игроков для одного доигрывания; state — рабочая копия
+    void sample(RolloutState& state, std::vector<Role>& scratch, SplitMix64& rng) const {
+        state = base;
+        scratch.assign(pool.begin(), pool.end());
+        std::array<Role, 3> order{};
+        std::copy(subtypes.begin(), subtypes.end(), order.begin());
+        std::shuffle(order.begin(), order.begin() + subtypes.size(), rng);
+        for (int i = 0; i < mafiaUnknown; ++i) {
+            scratch.push_back(static_cast<size_t>(i) < subtypes.size() ? order[i] : Role::Mafia);
+        }
+        // составы могут не сойтись, если человек выбрал роль сам; тогда недостающие — мирные
+        scratch.resize(unknown.size(), Role::Civilian);
+        std::shuffle(scratch.begin(), scratch.end(), rng);
+
+        // вскрытия и проверки комиссара: если роль не подходит, меняемся с тем, кому подходят обе роли
+        for (size_t i = 0; i < unknown.size(); ++i) {
+            if (allows(unknown[i].allowed, scratch[i])) {
+                continue;
+            }
+            for (size_t j = 0; j < unknown.size(); ++j) {
+                if (allows(unknown[i].allowed, scratch[j]) && allows(unknown[j].allowed, scratch[i])) {
+                    std::swap(scratch[i], scratch[j]);
+                    break;
+                }
+            }
+        }
+        for (size_t i = 0; i < unknown.size(); ++i) {
+            state.setRole(unknown[i].id, scratch[i]);
+        }
+        state.countFactions();
+    }
+
+private:
+    static constexpr RoleMask AnyRole = static_cast<RoleMask>((1u << RoleCount) - 1);
+    static constexpr RoleMask MafiaRoles = roleMaskWhere([](const RoleTraits& traits) { return traits.faction == Faction::Mafia; });
+    static constexpr RoleMask VisibleRoles = roleMaskWhere([](const RoleTraits& traits) { return traits.visibleToCommissar; });
+
+    struct Unknown {
+        PlayerId id;
+        RoleMask allowed;
+    };
+
+    RolloutState base;
+    std::vector<Unknown> unknown;
+    std::vector<Role> pool;      // роли неизвестных кроме мафии
+    std::vector<Role> subtypes;  // подвиды мафии, которых еще не видели
+    int mafiaUnknown = 0;        // сколько мафии среди неизвестных
+    Faction faction;
+
+    static constexpr RoleMask roleBit(Role role) {
+        return static_cast<RoleMask>(1u << static_cast<size_t>(role));
+    }
+
+    static bool allows(RoleMask allowed, Role role) {
+        return allowed & roleBit(role);
+    }
+
+    // роли, которые не противоречат объявленному о смерти игрока
+    static RoleMask revealedRoles(const Player& player) {
+        switch (player.getDeathReveal()) {
+            case DeathReveal::Faction:
+                return isMafiaRole(player.getRole()) ? MafiaRoles : static_cast<RoleMask>(~MafiaRoles);
+            case DeathReveal::Role: {
+                std::string_view revealName = roleTraits(player.getRole()).revealName;
+                RoleMask mask = 0;
+                for (size_t role = 0; role < RoleCount; ++role) {
+                    if (revealName == roleTraitsTable[role].revealName) {
+                        mask |= roleBit(static_cast<Role>(role));
+                    }
+                }
+                return mask;
+            }
+            case DeathReveal::None:
+                break;
+        }
+        return AnyRole;
+    }
+};
+
+class MctsStrategy : public PlayerStrategy {
+public:
+    // сколько доигрываний и за какое время сделали все стратегии процесса, для rollouts/s
+    struct Throughput {
+        std::atomic<std::uint64_t> rollouts{0};
+        std::atomic<std::uint64_t> searchNanoseconds{0};  // сумма времени решений
+
+        double rolloutsPerSecond() const {
+            std::uint64_t nanoseconds = searchNanoseconds.load(std::memory_order_relaxed);
+            return nanoseconds ? rollouts.load(std::memory_order_relaxed) * 1e9 / nanoseconds : 0.0;
+        }
+    };
+
+    // параметры нужно задать до первого решения
+    static MctsOptions& sharedOptions() {
+        static MctsOptions options;
+        return options;
+    }
+
+    static Throughput& throughput() {
+        static Throughput counters;
+        return counters;
+    }
+
+    MctsStrategy(PlayerId self, std::uint64_t seed) : self(self), rng(seed) {}
+
+    cppcoro::task<PlayerId> vote(
+        const std::vector<MySharedPtr<Player>>& players,
+        TargetFilter targetFilter) override {
+
+        std::vector<RolloutMove> moves;
+        for (PlayerId target : candidates(players, targetFilter)) {
+            moves.push_back({self, RolloutAction::Vote, target});
+        }
+        if (moves.empty()) {
+            co_return NoPlayer;
+        }
+        co_return moves[search(players, false, moves)].target;
+    }
+
+    cppcoro::task<NightAction> chooseAction(
+        const std::vector<MySharedPtr<Player>>& players,
+        std::span<const ActionKind> availableActions,
+        TargetFilter targetFilter) override {
+
+        std::vector<RolloutMove> moves;
+        std::vector<ActionKind> actionOf;
+        std::vector<PlayerId> targets = candidates(players, targetFilter);
+        for (ActionKind action : availableActions) {
+            RolloutAction kind = action == ActionKind::Heal    ? RolloutAction::Heal
+                                 : action == ActionKind::Check ? RolloutAction::Check
+                                                               : RolloutAction::Kill;
+            for (PlayerId target : targets) {
+                moves.push_back({self, kind, target});
+                actionOf.push_back(action);
+            }
+        }
+        if (moves.empty()) {
+            co_return NightAction{};
+        }
+        size_t best = search(players, true, moves);
+        co_return NightAction{actionOf[best], moves[best].target};
+    }
+
+    std::uint64_t randomState() const override { return rng.getState(); }
+    void setRandomState(std::uint64_t state) override { rng = SplitMix64(state); }
+
+private:
+    PlayerId self;
+    SplitMix64 rng;
+
+    // статистика ходов корня в одном дереве
+    struct RootStats {
+        std::vector<std::uint32_t> visits;
+        std::vector<double> wins;
+        std::uint64_t rollouts = 0;
+    };
+
+    // пул доигрываний свой: решения сами могут идти на пуле решений и ждать здесь
+    static cppcoro::static_thread_pool& rolloutPool() {
+        static cppcoro::static_thread_pool pool(static_cast<std::uint32_t>(std::max(1, sharedOptions().threads)));
+        return pool;
+    }
+
+    std::vector<PlayerId> candidates(const std::vector<MySharedPtr<Player>>& players, TargetFilter targetFilter) {
+        std::vector<PlayerId> targets;
+        for (const auto& player : players) {
+            if (targetFilter(*player)) {
+                targets.push_back(player->getId());
+            }
+        }
+        size_t limit = std::max<size_t>(1, sharedOptions().maxCandidates);
+        if (targets.size() > limit) {
+            for (size_t i = 0; i < limit; ++i) {
+                std::swap(targets[i], targets[std::uniform_int_distribution<size_t>(i, targets.size() - 1)(rng)]);
+            }
+            targets.resize(limit);
+        }
+        return targets;
+    }
+
+    // индекс лучшего хода: больше всего посещений по всем деревьям, при равенстве — выше доля побед
+    size_t search(const std::vector<MySharedPtr<Player>>& players, bool night, const std::vector<RolloutMove>& moves) {
+        const MctsOptions& options = sharedOptions();
+        auto start = std::chrono::steady_clock::now();
+        RoleSampler sampler(players, self);
+        std::uint64_t searchSeed = rng();
+
+        int trees = std::max(1, options.trees);
+        std::uint64_t totalRollouts = options.rollouts > 0 ? static_cast<std::uint64_t>(options.rollouts)
+                                                           : std::numeric_limits<std::uint64_t>::max();
+        auto deadline = options.timeBudget.count() > 0 ? start + options.timeBudget : std::chrono::steady_clock::time_point::max();
+        if (options.rollouts <= 0 && options.timeBudget.count() <= 0) {
+            totalRollouts = 1;
+        }
+
+        std::vector<cppcoro::task<RootStats>> searches;
+        for (int tree = 0; tree < trees; ++tree) {
+            std::uint64_t quota = totalRollouts == std::numeric_limits<std::uint64_t>::max()
+                                      ? totalRollouts
+                                      : totalRollouts * (tree + 1) / trees - totalRollouts * tree / trees;
+            searches.push_back(searchTree(sampler, night, moves, SplitMix64::streamSeed(searchSeed, tree), quota, deadline,
+                                          options.exploration));
+        }
+        std::vector<RootStats> results = runDecisionsOn(trees > 1 ? &rolloutPool() : nullptr, std::move(searches));
+
+        std::vector<std::uint64_t> visits(moves.size(), 0);
+        std::vector<double> wins(moves.size(), 0.0);
+        std::uint64_t rollouts = 0;
+        for (const RootStats& stats : results) {
+            for (size_t move = 0; move < moves.size(); ++move) {
+                visits[move] += stats.visits[move];
+                wins[move] += stats.wins[move];
+            }
+            rollouts += stats.rollouts;
+        }
+
+        size_t best = 0;
+        for (size_t move = 1; move < moves.size(); ++move) {
+            if (visits[move] > visits[best] ||
+                (visits[move] == visits[best] && wins[move] * visits[best] > wins[best] * visits[move])) {
+                best = move;
+            }
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+        throughput().rollouts.fetch_add(rollouts, std::memory_order_relaxed);
+        throughput().searchNanoseconds.fetch_add(static_cast<std::uint64_t>(elapsed.count()), std::memory_order_relaxed);
+        return best;
+    }
+
+    // одно дерево: UCB1 по ходам корня, каждое доигрывание со своим розыгрышем ролей
+    static cppcoro::task<RootStats> searchTree(const RoleSampler& sampler, bool night, const std::vector<RolloutMove>& moves,
+                                               std::uint64_t seed, std::uint64_t quota,
+                                               std::chrono::steady_clock::time_point deadline, double exploration) {
+        SplitMix64 treeRng(seed);
+        RootStats stats;
+        stats.visits.assign(moves.size(), 0);
+        stats.wins.assign(moves.size(), 0.0);
+        RolloutState state;
+        std::vector<Role> scratch;
+        std::vector<int> votes;
+        bool timed = deadline != std::chrono::steady_clock::time_point::max();
+
+        while (stats.rollouts < quota && (!timed || std::chrono::steady_clock::now() < deadline)) {
+            size_t move = stats.rollouts < moves.size() ? stats.rollouts : 0;
+            if (stats.rollouts >= moves.size()) {
+                double logTotal = std::log(static_cast<double>(stats.rollouts));
+                double bestScore = -1.0;
+                for (size_t candidate = 0; candidate < moves.size(); ++candidate) {
+                    double score = stats.wins[candidate] / stats.visits[candidate] +
+                                   exploration * std::sqrt(logTotal / stats.visits[candidate]);
+                    if (score > bestScore) {
+                        bestScore = score;
+                        move = candidate;
+                    }
+                }
+            }
+
+            sampler.sample(state, scratch, treeRng);
+            votes.assign(state.roles.size(), 0);
+            std::optional<Faction> winner = playOut(state, night, moves[move], treeRng, votes);
+            stats.wins[move] += !winner ? 0.5 : *winner == sampler.ownFaction() ? 1.0 : 0.0;
+            ++stats.visits[move];
+            ++stats.rollouts;
+        }
+        co_return stats;
+    }
+
+    // доигрывание с хода move до конца игры; пусто — игра не кончилась за отведенное число фаз
+    static std::optional<Faction> playOut(RolloutState& state, bool night, const RolloutMove& move, SplitMix64& rng,
+                                          std::vector<int>& votes) {
+        const RolloutMove* fixed = &move;
+        size_t maxPhases = 4 * state.roles.size() + 8;
+        for (size_t phase = 0; phase < maxPhases; ++phase) {
+            if (night) {
+                state.playNight(rng, fixed, votes);
+            } else {
+                state.playDay(rng, fixed, votes);
+            }
+            fixed = nullptr;
+            night = !night;
+            if (auto winner = state.winner()) {
+                return winner;
+            }
+        }
+        return std::nullopt;
+    }
+};
+
+#endif // MCTSSTRATEGY_H
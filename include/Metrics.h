@@ -0,0 +1,334 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// участки горячего пути, время которых замеряется. Участки вкладываются: фаза включает сбор решений и вывод
+enum class MetricSection : std::uint8_t {
+    Game,
+    AssignRoles,
+    DayPhase,
+    CollectVotes,
+    TallyVotes,
+    NightPhase,
+    CollectNightActions,
+    ResolveNight,
+    AnnounceNight,
+    Output,
+    Log,
+    Count
+};
+
+enum class MetricCounter : std::uint8_t {
+    Games,
+    Votes,
+    NightActions,
+    Kills,
+    LogRecords,
+    Count
+};
+
+constexpr size_t MetricSectionCount = static_cast<size_t>(MetricSection::Count);
+constexpr size_t MetricCounterCount = static_cast<size_t>(MetricCounter::Count);
+
+inline constexpr std::array<const char*, MetricSectionCount> metricSectionNames = {
+    "game", "assign_roles", "day_phase", "collect_votes", "tally_votes", "night_phase",
+    "collect_night_actions", "resolve_night", "announce_night", "output", "log"};
+
+inline constexpr std::array<const char*, MetricCounterCount> metricCounterNames = {
+    "games", "votes", "night_actions", "kills", "log_records"};
+
+// гистограмма задержек в наносекундах в духе HDR: 8 подкорзин на каждую степень двойки,
+// то есть относительная точность 12.5% на всем диапазоне uint64 при 496 корзинах
+struct HistogramSnapshot {
+    static constexpr int SubBits = 3;
+    static constexpr std::uint64_t SubBuckets = 1 << SubBits;
+    static constexpr size_t BucketCount = SubBuckets * (64 - SubBits + 1);
+
+    std::array<std::uint64_t, BucketCount> buckets{};
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t min = std::numeric_limits<std::uint64_t>::max();
+    std::uint64_t max = 0;
+
+    static size_t bucketOf(std::uint64_t value) {
+        if (value < SubBuckets) {
+            return static_cast<size_t>(value);
+        }
+        int exponent = std::bit_width(value) - 1;
+        return (exponent - SubBits + 1) * SubBuckets + ((value >> (exponent - SubBits)) & (SubBuckets - 1));
+    }
+
+    // наибольшее значение, которое попадает в корзину
+    static std::uint64_t bucketUpperBound(size_t bucket) {
+        if (bucket < SubBuckets) {
+            return bucket;
+        }
+        int shift = static_cast<int>(bucket / SubBuckets) - 1;
+        std::uint64_t lower = (SubBuckets + bucket % SubBuckets) << shift;
+        return lower + ((std::uint64_t{1} << shift) - 1);
+    }
+
+    void merge(const HistogramSnapshot& other) {
+        for (size_t i = 0; i < BucketCount; ++i) {
+            buckets[i] += other.buckets[i];
+        }
+        count += other.count;
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+
+    // верхняя граница корзины, в которой лежит q-я доля значений (ранг ceil(q * count))
+    std::uint64_t percentile(double q) const {
+        if (count == 0) {
+            return 0;
+        }
+        auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count))));
+        std::uint64_t seen = 0;
+        for (size_t i = 0; i < BucketCount; ++i) {
+            seen += buckets[i];
+            if (seen >= rank) {
+                return std::min(bucketUpperBound(i), max);
+            }
+        }
+        return max;
+    }
+
+    // сколько значений не больше limit; корзину, которую граница режет, относим к следующей
+    std::uint64_t countAtMost(std::uint64_t limit) const {
+        std::uint64_t total = 0;
+        for (size_t i = 0; i < BucketCount && bucketUpperBound(i) <= limit; ++i) {
+            total += buckets[i];
+        }
+        return total;
+    }
+};
+
+struct MetricsSnapshot {
+    std::array<HistogramSnapshot, MetricSectionCount> sections;
+    std::array<std::uint64_t, MetricCounterCount> counters{};
+    size_t threads = 0;
+};
+
+struct MetricsOptions {
+    // при выходе пишутся <prefix>.json и <prefix>.prom; расширение в prefix отбрасывается,
+    // так что и m, и m.json, и m.prom дают m.json и m.prom
+    std::string outputPrefix = "mafia_metrics";
+};
+
+// метрики процесса. Каждый поток пишет только в свои гистограммы и счетчики, без блокировок и
+// без общих кэш-линий; атомарные они только для того, чтобы снимок можно было читать из другого потока.
+// данные завершившихся потоков остаются в реестре до конца процесса
+class Metrics {
+public:
+    using Options = MetricsOptions;
+
+    static void record(MetricSection section, std::uint64_t nanoseconds) {
+        ThreadMetrics& metrics = local();
+        Histogram& histogram = metrics.sections[static_cast<size_t>(section)];
+        bump(histogram.buckets[HistogramSnapshot::bucketOf(nanoseconds)], 1);
+        bump(histogram.count, 1);
+        bump(histogram.sum, nanoseconds);
+        if (nanoseconds < histogram.min.load(std::memory_order_relaxed)) {
+            histogram.min.store(nanoseconds, std::memory_order_relaxed);
+        }
+        if (nanoseconds > histogram.max.load(std::memory_order_relaxed)) {
+            histogram.max.store(nanoseconds, std::memory_order_relaxed);
+        }
+    }
+
+    static void count(MetricCounter counter, std::uint64_t n = 1) {
+        bump(local().counters[static_cast<size_t>(counter)], n);
+    }
+
+    static MetricsSnapshot snapshot() {
+        Registry& r = registry();
+        std::lock_guard lock(r.mutex);
+        MetricsSnapshot total;
+        total.threads = r.threads.size();
+        for (const auto& thread : r.threads) {
+            for (size_t s = 0; s < MetricSectionCount; ++s) {
+                total.sections[s].merge(thread->sections[s].snapshot());
+            }
+            for (size_t c = 0; c < MetricCounterCount; ++c) {
+                total.counters[c] += thread->counters[c].load(std::memory_order_relaxed);
+            }
+        }
+        return total;
+    }
+
+    static Options& sharedOptions() {
+        static Options options;
+        return options;
+    }
+
+    // файлы пишутся во временные и переименовываются, так что читатель с диска не увидит половину файла
+    static bool writeFiles() {
+        MetricsSnapshot data = snapshot();
+        std::string base = outputBase();
+        return writeAtomically(base + ".json", [&](std::ostream& out) { writeJson(out, data); }) &&
+               writeAtomically(base + ".prom", [&](std::ostream& out) { writePrometheus(out, data); });
+    }
+
+    // outputPrefix без расширения
+    static std::string outputBase() {
+        return std::filesystem::path(sharedOptions().outputPrefix).replace_extension().string();
+    }
+
+    static void writeJson(std::ostream& out, const MetricsSnapshot& data) {
+        out << "{\n  \"threads\": " << data.threads << ",\n  \"sections\": {\n";
+        for (size_t s = 0; s < MetricSectionCount; ++s) {
+            const HistogramSnapshot& h = data.sections[s];
+            out << "    \"" << metricSectionNames[s] << "\": {\"count\": " << h.count << ", \"sum_ns\": " << h.sum
+                << ", \"min_ns\": " << (h.count ? h.min : 0) << ", \"max_ns\": " << h.max
+                << ", \"mean_ns\": " << (h.count ? h.sum / h.count : 0) << ", \"p50_ns\": " << h.percentile(0.5)
+                << ", \"p90_ns\": " << h.percentile(0.9) << ", \"p99_ns\": " << h.percentile(0.99)
+                << ", \"p999_ns\": " << h.percentile(0.999) << "}" << (s + 1 < MetricSectionCount ? "," : "") << "\n";
+        }
+        out << "  },\n  \"counters\": {\n";
+        for (size_t c = 0; c < MetricCounterCount; ++c) {
+            out << "    \"" << metricCounterNames[c] << "\": " << data.counters[c] << (c + 1 < MetricCounterCount ? "," : "") << "\n";
+        }
+        out << "  }\n}\n";
+    }
+
+    // текстовый формат Prometheus: одна гистограмма с меткой section и по счетчику на событие
+    static void writePrometheus(std::ostream& out, const MetricsSnapshot& data) {
+        static constexpr double bounds[] = {1e-6, 2e-6, 5e-6, 1e-5, 2e-5, 5e-5, 1e-4, 2e-4, 5e-4, 1e-3, 2e-3,
+                                            5e-3, 1e-2, 2e-2, 5e-2, 0.1, 0.2, 0.5, 1.0, 2.0, 5.0, 10.0};
+        out << std::setprecision(12);
+        out << "# HELP mafia_section_duration_seconds Time spent in a game engine section.\n";
+        out << "# TYPE mafia_section_duration_seconds histogram\n";
+        for (size_t s = 0; s < MetricSectionCount; ++s) {
+            const HistogramSnapshot& h = data.sections[s];
+            const char* name = metricSectionNames[s];
+            for (double bound : bounds) {
+                out << "mafia_section_duration_seconds_bucket{section=\"" << name << "\",le=\"" << bound << "\"} "
+                    << h.countAtMost(static_cast<std::uint64_t>(std::llround(bound * 1e9))) << "\n";
+            }
+            out << "mafia_section_duration_seconds_bucket{section=\"" << name << "\",le=\"+Inf\"} " << h.count << "\n";
+            out << "mafia_section_duration_seconds_sum{section=\"" << name << "\"} " << static_cast<double>(h.sum) * 1e-9 << "\n";
+            out << "mafia_section_duration_seconds_count{section=\"" << name << "\"} " << h.count << "\n";
+        }
+        for (size_t c = 0; c < MetricCounterCount; ++c) {
+            out << "# TYPE mafia_" << metricCounterNames[c] << "_total counter\n";
+            out << "mafia_" << metricCounterNames[c] << "_total " << data.counters[c] << "\n";
+        }
+    }
+
+private:
+    struct Histogram {
+        std::array<std::atomic<std::uint64_t>, HistogramSnapshot::BucketCount> buckets{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> sum{0};
+        std::atomic<std::uint64_t> min{std::numeric_limits<std::uint64_t>::max()};
+        std::atomic<std::uint64_t> max{0};
+
+        HistogramSnapshot snapshot() const {
+            HistogramSnapshot result;
+            for (size_t i = 0; i < HistogramSnapshot::BucketCount; ++i) {
+                result.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            }
+            result.count = count.load(std::memory_order_relaxed);
+            result.sum = sum.load(std::memory_order_relaxed);
+            result.min = min.load(std::memory_order_relaxed);
+            result.max = max.load(std::memory_order_relaxed);
+            return result;
+        }
+    };
+
+    struct ThreadMetrics {
+        std::array<Histogram, MetricSectionCount> sections;
+        std::array<std::atomic<std::uint64_t>, MetricCounterCount> counters{};
+    };
+
+    struct Registry {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<ThreadMetrics>> threads;
+    };
+
+    // писатель у значения один, поэтому обычные load и store вместо fetch_add с блокировкой шины
+    static void bump(std::atomic<std::uint64_t>& value, std::uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // реестр не уничтожается: потоки пула и отсоединенные потоки могут пережить статические объекты
+    static Registry& registry() {
+        static Registry* r = new Registry();
+        return *r;
+    }
+
+    static ThreadMetrics& local() {
+        thread_local ThreadMetrics* mine = [] {
+            Registry& r = registry();
+            std::lock_guard lock(r.mutex);
+            r.threads.push_back(std::make_unique<ThreadMetrics>());
+            return r.threads.back().get();
+        }();
+        return *mine;
+    }
+
+    template <typename Write>
+    static bool writeAtomically(const std::string& path, Write write) {
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            if (!out) {
+                return false;
+            }
+            write(out);
+            if (!out) {
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        return !error;
+    }
+};
+
+// замеряет время от создания до конца области видимости
+class ScopedMetricTimer {
+public:
+    explicit ScopedMetricTimer(MetricSection section) : section(section), start(std::chrono::steady_clock::now()) {}
+
+    ~ScopedMetricTimer() {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::record(section, static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    ScopedMetricTimer(const ScopedMetricTimer&) = delete;
+    ScopedMetricTimer& operator=(const ScopedMetricTimer&) = delete;
+
+private:
+    MetricSection section;
+    std::chrono::steady_clock::time_point start;
+};
+
+// без MAFIA_METRICS (опция MAFIA_ENABLE_METRICS) макросы пустые: ни часов, ни счетчиков в горячем пути
+#ifdef MAFIA_METRICS
+#define MAFIA_METRICS_CONCAT_(a, b) a##b
+#define MAFIA_METRICS_CONCAT(a, b) MAFIA_METRICS_CONCAT_(a, b)
+#define MAFIA_TIME_SECTION(section) ScopedMetricTimer MAFIA_METRICS_CONCAT(metricTimer, __LINE__)(section)
+#define MAFIA_COUNT(counter, n) Metrics::count(counter, n)
+#else
+#define MAFIA_TIME_SECTION(section) ((void)0)
+#define MAFIA_COUNT(counter, n) ((void)0)
+#endif
+
+#endif // METRICS_H
@@ -1,96 +1,212 @@
 #ifndef MYSHAREDPTR_H
 #define MYSHAREDPTR_H
 
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
 #include <type_traits>  // подключим для std::enable_if std::is_convertible
 
-template <typename T>
-class MySharedPtr {
+// политики подсчета ссылок. Обычный счетчик дешевле, но указатель с ним нельзя
+// копировать и уничтожать одновременно из разных потоков
+
+struct MySingleThreadCounting {
+    using Counter = unsigned int;
+
+    static void increment(Counter& count) noexcept {
+        ++count;
+    }
+
+    // true, если это была последняя ссылка
+    static bool decrement(Counter& count) noexcept {
+        return --count == 0;
+    }
+
+    static unsigned int load(const Counter& count) noexcept {
+        return count;
+    }
+};
+
+struct MyAtomicCounting {
+    using Counter = std::atomic<unsigned int>;
+
+    static void increment(Counter& count) noexcept {
+        // новая ссылка берется из существующей, поэтому упорядочивать нечего
+        count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    static bool decrement(Counter& count) noexcept {
+        // release публикует наши записи в объект, acquire дает удаляющему потоку увидеть записи всех остальных владельцев
+        return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+    }
+
+    static unsigned int load(const Counter& count) noexcept {
+        return count.load(std::memory_order_relaxed);
+    }
+};
+
+// блок управления: счетчик ссылок и знание о том, как уничтожить объект.
+// благодаря ему MySharedPtr<Base>, полученный из MySharedPtr<Derived>, удаляет объект как Derived
+template <typename Counting>
+class MySharedControlBlock {
+public:
+    typename Counting::Counter refCount{1};
+
+    // уничтожает объект и освобождает сам блок
+    virtual void destroy() noexcept = 0;
+
+protected:
+    ~MySharedControlBlock() = default;
+};
+
+// блок для указателя, созданного снаружи через new
+template <typename T, typename Counting>
+class MySharedPointerBlock final : public MySharedControlBlock<Counting> {
+public:
+    explicit MySharedPointerBlock(T* p) : ptr(p) {}
+
+    void destroy() noexcept override {
+        delete ptr;
+        delete this;
+    }
+
 private:
     T* ptr;
-    unsigned int* refCount;
+};
 
-    template <typename U>
-    friend class MySharedPtr;
+// блок, внутри которого лежит сам объект: одно выделение памяти вместо двух
+template <typename T, typename Counting>
+class MySharedInplaceBlock final : public MySharedControlBlock<Counting> {
+public:
+    template <typename... Args>
+    explicit MySharedInplaceBlock(Args&&... args) {
+        ::new (static_cast<void*>(storage)) T(std::forward<Args>(args)...);
+    }
 
+    T* object() noexcept {
+        return std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    void destroy() noexcept override {
+        object()->~T();
+        delete this;
+    }
+
+private:
+    alignas(T) unsigned char storage[sizeof(T)];
+};
+
+// то же, но память берется из memory_resource (например, из арены игры)
+template <typename T, typename Counting>
+class MySharedResourceBlock final : public MySharedControlBlock<Counting> {
 public:
-    MySharedPtr() : ptr(nullptr), refCount(new unsigned int(0)) {}
-    MySharedPtr(T* p) : ptr(p), refCount(new unsigned int(1)) {}
-    MySharedPtr(const MySharedPtr& other) : ptr(other.ptr), refCount(other.refCount) {
-        if (ptr) {
-            (*refCount)++;
+    template <typename... Args>
+    explicit MySharedResourceBlock(std::pmr::memory_resource* resource, Args&&... args) : resource(resource) {
+        ::new (static_cast<void*>(storage)) T(std::forward<Args>(args)...);
+    }
+
+    T* object() noexcept {
+        return std::launder(reinterpret_cast<T*>(storage));
+    }
+
+    void destroy() noexcept override {
+        object()->~T();
+        std::pmr::memory_resource* owner = resource;
+        this->~MySharedResourceBlock();
+        owner->deallocate(this, sizeof(MySharedResourceBlock), alignof(MySharedResourceBlock));
+    }
+
+private:
+    std::pmr::memory_resource* resource;
+    alignas(T) unsigned char storage[sizeof(T)];
+};
+
+// по умолчанию счетчик обычный: игра целиком живет в одном потоке.
+// для указателей, которые передаются между потоками, есть MyAtomicSharedPtr
+template <typename T, typename Counting = MySingleThreadCounting>
+class MySharedPtr {
+private:
+    using ControlBlock = MySharedControlBlock<Counting>;
+
+    T* ptr = nullptr;
+    ControlBlock* block = nullptr;  // nullptr у пустого указателя, ничего не выделяем
+
+    template <typename U, typename C>
+    friend class MySharedPtr;
+
+    template <typename U, typename C, typename... Args>
+    friend MySharedPtr<U, C> make_my_shared(Args&&... args);
+
+    template <typename U, typename C, typename... Args>
+    friend MySharedPtr<U, C> allocate_my_shared(std::pmr::memory_resource* resource, Args&&... args);
+
+    // забирает уже посчитанную ссылку
+    MySharedPtr(T* p, ControlBlock* b) noexcept : ptr(p), block(b) {}
+
+    void retain() const noexcept {
+        if (block) {
+            Counting::increment(block->refCount);
         }
     }
 
-    template <typename U>
-    MySharedPtr(const MySharedPtr<U>& other, typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = nullptr)
-        : ptr(other.ptr), refCount(other.refCount) {
-        if (ptr) {
-            (*refCount)++;
+    void release() noexcept {
+        if (block && Counting::decrement(block->refCount)) {
+            block->destroy();
         }
     }
 
+public:
+    MySharedPtr() noexcept = default;
+    MySharedPtr(std::nullptr_t) noexcept {}
+    MySharedPtr(T* p) : ptr(p), block(p ? new MySharedPointerBlock<T, Counting>(p) : nullptr) {}
+
+    MySharedPtr(const MySharedPtr& other) noexcept : ptr(other.ptr), block(other.block) {
+        retain();
+    }
+
+    MySharedPtr(MySharedPtr&& other) noexcept : ptr(other.ptr), block(other.block) {
+        other.ptr = nullptr;
+        other.block = nullptr;
+    }
+
+    template <typename U>
+    MySharedPtr(const MySharedPtr<U, Counting>& other, typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = nullptr) noexcept
+        : ptr(other.ptr), block(other.block) {
+        retain();
+    }
+
+    template <typename U>
+    MySharedPtr(MySharedPtr<U, Counting>&& other, typename std::enable_if<std::is_convertible<U*, T*>::value>::type* = nullptr) noexcept
+        : ptr(other.ptr), block(other.block) {
+        other.ptr = nullptr;
+        other.block = nullptr;
+    }
+
     ~MySharedPtr() {
-        if (refCount) {
-            (*refCount)--;
-            if (*refCount == 0) {
-                delete ptr;
-                delete refCount;
-            }
-        }
+        release();
     }
 
-    MySharedPtr& operator=(const MySharedPtr& other) {
-        if (this != &other) {
-            if (refCount) {
-                (*refCount)--;
-                if (*refCount == 0) {
-                    delete ptr;
-                    delete refCount;
-                }
-            }
-            ptr = other.ptr;
-            refCount = other.refCount;
-            if (ptr) {
-                (*refCount)++;
-            }
-        }
+    MySharedPtr& operator=(const MySharedPtr& other) noexcept {
+        MySharedPtr(other).swap(*this);
         return *this;
     }
 
     template <typename U>
-    MySharedPtr& operator=(const MySharedPtr<U>& other) {
-        if (ptr != other.ptr) {
-            if (refCount) {
-                (*refCount)--;
-                if (*refCount == 0) {
-                    delete ptr;
-                    delete refCount;
-                }
-            }
-            ptr = other.ptr;
-            refCount = other.refCount;
-            if (ptr) {
-                (*refCount)++;
-            }
-        }
+    MySharedPtr& operator=(const MySharedPtr<U, Counting>& other) noexcept {
+        MySharedPtr(other).swap(*this);
         return *this;
     }
 
-    MySharedPtr& operator=(MySharedPtr&& other) {
-        if (this != &other) {
-            if (refCount) {
-                (*refCount)--;
-                if (*refCount == 0) {
-                    delete ptr;
-                    delete refCount;
-                }
-            }
-            ptr = other.ptr;
-            refCount = other.refCount;
-            other.ptr = nullptr;
-            other.refCount = nullptr;
-        }
+    MySharedPtr& operator=(MySharedPtr&& other) noexcept {
+        MySharedPtr(std::move(other)).swap(*this);
+        return *this;
+    }
+
+    template <typename U>
+    MySharedPtr& operator=(MySharedPtr<U, Counting>&& other) noexcept {
+        MySharedPtr(std::move(other)).swap(*this);
         return *this;
     }
 
@@ -110,25 +226,13 @@ public:
 
     void reset(T* p = nullptr) {
         if (ptr != p) {
-            if (refCount) {
-                (*refCount)--;
-                if (*refCount == 0) {
-                    delete ptr;
-                    delete refCount;
-                }
-            }
-            ptr = p;
-            if (ptr) {
-                refCount = new unsigned int(1);
-            } else {
-                refCount = new unsigned int(0);
-            }
+            MySharedPtr(p).swap(*this);
         }
     }
 
-    void swap(MySharedPtr& other) {
+    void swap(MySharedPtr& other) noexcept {
         std::swap(ptr, other.ptr);
-        std::swap(refCount, other.refCount);
+        std::swap(block, other.block);
     }
 
     T* get() const {
@@ -144,8 +248,38 @@ public:
     }
 
     unsigned int use_count() const {
-        return refCount ? *refCount : 0;
+        return block ? Counting::load(block->refCount) : 0;
     }
 };
 
+template <typename T>
+using MyAtomicSharedPtr = MySharedPtr<T, MyAtomicCounting>;
+
+// объект и счетчик в одном выделении памяти, как std::make_shared
+template <typename T, typename Counting = MySingleThreadCounting, typename... Args>
+MySharedPtr<T, Counting> make_my_shared(Args&&... args) {
+    auto* block = new MySharedInplaceBlock<T, Counting>(std::forward<Args>(args)...);
+    return MySharedPtr<T, Counting>(block->object(), block);
+}
+
+// объект и счетчик в одном куске памяти из resource; память возвращается туда же
+template <typename T, typename Counting = MySingleThreadCounting, typename... Args>
+MySharedPtr<T, Counting> allocate_my_shared(std::pmr::memory_resource* resource, Args&&... args) {
+    using Block = MySharedResourceBlock<T, Counting>;
+    void* memory = resource->allocate(sizeof(Block), alignof(Block));
+    Block* block;
+    try {
+        block = ::new (memory) Block(resource, std::forward<Args>(args)...);
+    } catch (...) {
+        resource->deallocate(memory, sizeof(Block), alignof(Block));
+        throw;
+    }
+    return MySharedPtr<T, Counting>(block->object(), block);
+}
+
+template <typename T, typename... Args>
+MyAtomicSharedPtr<T> make_my_atomic_shared(Args&&... args) {
+    return make_my_shared<T, MyAtomicCounting>(std::forward<Args>(args)...);
+}
+
 #endif // MYSHAREDPTR_H
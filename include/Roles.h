@@ -0,0 +1,187 @@
+#ifndef ROLES_H
+#define ROLES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// роль хранится в игроке как байт, а все ее свойства берутся из таблицы ниже,
+// поэтому горячим путям не нужен dynamic_cast
+
+enum class Role : std::uint8_t {
+    Civilian,
+    Doctor,
+    Commissar,
+    Maniac,
+    Mafia,
+    Bull,
+    Ninja,
+    Killer
+};
+
+constexpr size_t RoleCount = 8;
+
+enum class Faction : std::uint8_t {
+    Civilians,
+    Mafia,
+    Maniac
+};
+
+constexpr size_t FactionCount = 3;
+
+// что объявили о мертвом игроке: казнь показывает только «мафия или нет»,
+// ночная смерть — RoleTraits::revealName, то есть роль без подвида мафии
+enum class DeathReveal : std::uint8_t {
+    None,     // жив
+    Faction,
+    Role
+};
+
+constexpr size_t DeathRevealCount = 3;
+
+// ночное действие; None — ничего не делать
+enum class ActionKind : std::uint8_t {
+    None,
+    Kill,
+    Heal,
+    Check
+};
+
+constexpr size_t ActionKindCount = 4;
+
+// имя действия при вводе в консоли и в логах
+constexpr const char* actionKey(ActionKind kind) {
+    switch (kind) {
+        case ActionKind::Kill: return "kill";
+        case ActionKind::Heal: return "heal";
+        case ActionKind::Check: return "check";
+        case ActionKind::None: break;
+    }
+    return "";
+}
+
+// наборы ночных действий ролей, на них ссылается таблица ниже
+inline constexpr ActionKind killActions[] = {ActionKind::Kill};
+inline constexpr ActionKind healActions[] = {ActionKind::Heal};
+inline constexpr ActionKind checkOrKillActions[] = {ActionKind::Check, ActionKind::Kill};
+
+// ночные убийства применяются в порядке приоритета, у каждого приоритета одна жертва за ночь
+constexpr int NoKill = -1;
+constexpr int MafiaKillPriority = 0;
+constexpr int KillPriorityCount = 4;
+
+struct RoleTraits {
+    Faction faction;
+    bool visibleToCommissar;  // проверка комиссара покажет «мафия»
+    bool immuneToManiac;
+    bool joinsMafiaVote;      // ночью голосует за общую жертву мафии
+    int killPriority;         // приоритет собственного убийства или NoKill
+    const char* key;          // имя роли при выборе в консоли
+    const char* name;         // «получил роль: ...»
+    const char* revealName;   // «Он был ...» при вскрытии
+    const char* title;        // роль в итоговом логе
+    std::span<const ActionKind> nightActions;  // из чего роль выбирает ночью
+};
+
+constexpr std::array<RoleTraits, RoleCount> roleTraitsTable{{
+    {Faction::Civilians, false, false, false, NoKill, "civilian", "мирный житель", "мирным жителем", "Мирный житель", {}},
+    {Faction::Civilians, false, false, false, NoKill, "doctor", "доктор", "доктором", "Доктор", healActions},
+    {Faction::Civilians, false, false, false, 3, "commissar", "комиссар", "комиссаром", "Комиссар", checkOrKillActions},
+    {Faction::Maniac, false, false, false, 2, "maniac", "маньяк", "маньяком", "Маньяк", killActions},
+    {Faction::Mafia, true, false, true, NoKill, "mafia", "мафия", "мафией", "Мафия", killActions},
+    {Faction::Mafia, true, true, true, NoKill, "bull", "бык", "мафией", "Мафия", killActions},
+    {Faction::Mafia, false, false, true, NoKill, "ninja", "ниндзя", "мафией", "Мафия", killActions},
+    {Faction::Mafia, true, false, false, 1, "killer", "киллер", "мафией", "Мафия", killActions},
+}};
+
+constexpr const RoleTraits& roleTraits(Role role) {
+    return roleTraitsTable[static_cast<size_t>(role)];
+}
+
+constexpr bool isMafiaRole(Role role) {
+    return roleTraits(role).faction == Faction::Mafia;
+}
+
+// false, если такой роли нет
+constexpr bool roleFromKey(std::string_view key, Role& role) {
+    for (size_t i = 0; i < RoleCount; ++i) {
+        if (key == roleTraitsTable[i].key) {
+            role = static_cast<Role>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// во что превращается ночное действие роли при разборе ночи
+enum class NightRule : std::uint8_t {
+    None,       // действие ничего не делает
+    MafiaVote,  // голос за общую жертву мафии
+    Kill,       // собственное убийство с приоритетом RoleTraits::killPriority
+    Heal,
+    Check
+};
+
+// правила для всех пар (роль, действие) выводятся из таблицы ролей при компиляции,
+// так что новой роли достаточно строки в roleTraitsTable, а разбор ночи смотрит в готовую таблицу
+inline constexpr auto nightRuleTable = [] {
+    std::array<std::array<NightRule, ActionKindCount>, RoleCount> table{};
+    for (size_t role = 0; role < RoleCount; ++role) {
+        const RoleTraits& traits = roleTraitsTable[role];
+        for (ActionKind kind : traits.nightActions) {
+            NightRule rule = NightRule::None;
+            if (kind == ActionKind::Heal) {
+                rule = NightRule::Heal;
+            } else if (kind == ActionKind::Check) {
+                rule = NightRule::Check;
+            } else if (kind == ActionKind::Kill) {
+                rule = traits.joinsMafiaVote ? NightRule::MafiaVote : traits.killPriority != NoKill ? NightRule::Kill : NightRule::None;
+            }
+            table[role][static_cast<size_t>(kind)] = rule;
+        }
+    }
+    return table;
+}();
+
+constexpr NightRule nightRule(Role role, ActionKind kind) {
+    return nightRuleTable[static_cast<size_t>(role)][static_cast<size_t>(kind)];
+}
+
+// убийство с данным приоритетом. stoppedByImmunity — цель с RoleTraits::immuneToManiac переживает удар
+struct KillRule {
+    bool stoppedByImmunity;
+    const char* chosenMessage;  // «... выбрал жертву: »
+    const char* doneMessage;    // «... убил: »
+    const char* failedMessage;  // «... попытался убить », если удар остановил иммунитет
+};
+
+inline constexpr std::array<KillRule, KillPriorityCount> killRules{{
+    {false, "Мафия выбрала жертву: ", "Мафия убила: ", nullptr},
+    {false, "Киллер выбрал жертву: ", "Киллер убил: ", nullptr},
+    {true, "Маньяк выбрал жертву: ", "Маньяк убил: ", "Маньяк попытался убить "},
+    {false, "Комиссар выбрал жертву: ", "Комиссар убил: ", nullptr},
+}};
+
+static_assert(roleTraits(Role::Killer).killPriority != NoKill && !roleTraits(Role::Killer).joinsMafiaVote,
+              "киллер убивает сам, а не вместе с мафией");
+static_assert(!roleTraits(Role::Ninja).visibleToCommissar, "ниндзя не виден комиссару");
+static_assert(roleTraits(Role::Bull).immuneToManiac, "быка не может убить маньяк");
+static_assert(killRules[static_cast<size_t>(roleTraits(Role::Maniac).killPriority)].stoppedByImmunity,
+              "иммунитет быка останавливает только маньяка");
+static_assert(nightRule(Role::Mafia, ActionKind::Kill) == NightRule::MafiaVote &&
+              nightRule(Role::Civilian, ActionKind::Kill) == NightRule::None &&
+              nightRule(Role::Doctor, ActionKind::Heal) == NightRule::Heal &&
+              nightRule(Role::Commissar, ActionKind::Kill) == NightRule::Kill,
+              "правила ночи разошлись с таблицей ролей");
+static_assert([] {
+    for (size_t role = 0; role < RoleCount; ++role) {
+        if (role != static_cast<size_t>(Role::Commissar) && nightRuleTable[role][static_cast<size_t>(ActionKind::Check)] != NightRule::None) {
+            return false;
+        }
+    }
+    return true;
+}(), "проверки записывает Commissar, других проверяющих ролей движок не знает");
+
+#endif // ROLES_H
@@ -0,0 +1,27 @@
+#ifndef TEXTFORMAT_H
+#define TEXTFORMAT_H
+
+#include <charconv>
+#include <concepts>
+#include <string>
+#include <string_view>
+
+// дописывает части текста в out: строки, символы и целые. Целые печатаются через to_chars,
+// без потоков и локали, так что в буфер с запасом емкости запись идет без выделений памяти
+
+inline void appendPart(std::string& out, std::string_view text) { out.append(text); }
+inline void appendPart(std::string& out, char c) { out.push_back(c); }
+
+template <std::integral T>
+void appendPart(std::string& out, T value) {
+    char digits[24];
+    auto result = std::to_chars(digits, digits + sizeof(digits), value);
+    out.append(digits, result.ptr);
+}
+
+template <typename... Parts>
+void appendParts(std::string& out, const Parts&... parts) {
+    (appendPart(out, parts), ...);
+}
+
+#endif // TEXTFORMAT_H
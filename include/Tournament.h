@@ -0,0 +1,333 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory_resource>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Game.h"
+#include "MctsStrategy.h"
+
+// турнир стратегий: игры ботов, где места за столом делят стратегии из состава, и рейтинги Эло
+// по стратегиям и по паре «стратегия, роль». Роли в игре раздаются как обычно, случайно
+
+// стратегия, доступная турниру по имени. create получает память игры, место бота и его сид
+struct StrategyEntry {
+    using Create = MySharedPtr<PlayerStrategy> (*)(std::pmr::memory_resource* resource, PlayerId id, std::uint64_t seed);
+
+    std::string name;
+    Create create;
+};
+
+// реестр стратегий процесса. Свои стратегии добавляйте через add до начала турнира
+class StrategyRegistry {
+public:
+    static StrategyRegistry& shared() {
+        static StrategyRegistry registry;
+        return registry;
+    }
+
+    // false — стратегия с таким именем уже есть
+    bool add(std::string name, StrategyEntry::Create create) {
+        if (find(name)) {
+            return false;
+        }
+        entries.push_back({std::move(name), create});
+        return true;
+    }
+
+    const StrategyEntry* find(const std::string& name) const {
+        auto it = std::find_if(entries.begin(), entries.end(), [&](const StrategyEntry& entry) { return entry.name == name; });
+        return it != entries.end() ? &*it : nullptr;
+    }
+
+    const std::vector<StrategyEntry>& all() const { return entries; }
+
+private:
+    std::vector<StrategyEntry> entries;
+
+    StrategyRegistry() {
+        add("random", [](std::pmr::memory_resource* resource, PlayerId, std::uint64_t seed) -> MySharedPtr<PlayerStrategy> {
+            return allocate_my_shared<BotStrategy>(resource, seed);
+        });
+        add("grudge", [](std::pmr::memory_resource* resource, PlayerId, std::uint64_t seed) -> MySharedPtr<PlayerStrategy> {
+            return allocate_my_shared<GrudgeBotStrategy>(resource, seed);
+        });
+        add("mcts", [](std::pmr::memory_resource* resource, PlayerId id, std::uint64_t seed) -> MySharedPtr<PlayerStrategy> {
+            return allocate_my_shared<MctsStrategy>(resource, id, seed);
+        });
+    }
+};
+
+// рейтинги Эло. Стороны игры (мафия, мирные, маньяк) играют попарные матчи: рейтинг стороны — средний
+// рейтинг ее мест, победитель выигрывает у обеих, а две проигравшие стороны сыграли вничью. Поправка
+// стороны делится поровну между ее местами, так что сумма рейтингов не меняется. Ключ — стратегия или пара
+// «стратегия, роль»; по ролям мафия, которая выигрывает чаще, получает рейтинг выше, пока ожидание
+// не сравняется с частотой побед
+class EloTable {
+public:
+    static constexpr double InitialRating = 1500.0;
+    static constexpr double K = 16.0;
+
+    explicit EloTable(size_t numKeys) : ratings(numKeys, InitialRating), games(numKeys, 0), scores(numKeys, 0.0) {}
+
+    // keys[i] — ключ игрока на месте i, side[i] — его сторона
+    void playGame(const std::vector<size_t>& keys, const std::vector<Faction>& side, Faction winningSide) {
+        std::array<double, FactionCount> sideRating{};
+        std::array<int, FactionCount> sideSize{};
+        for (size_t i = 0; i < keys.size(); ++i) {
+            sideRating[static_cast<size_t>(side[i])] += ratings[keys[i]];
+            ++sideSize[static_cast<size_t>(side[i])];
+        }
+        for (size_t a = 0; a < FactionCount; ++a) {
+            if (sideSize[a] > 0) {
+                sideRating[a] /= sideSize[a];
+            }
+        }
+
+        std::array<double, FactionCount> sideDelta{};
+        for (size_t a = 0; a < FactionCount; ++a) {
+            for (size_t b = a + 1; b < FactionCount; ++b) {
+                if (sideSize[a] == 0 || sideSize[b] == 0) {
+                    continue;
+                }
+                double expected = 1.0 / (1.0 + std::pow(10.0, (sideRating[b] - sideRating[a]) / 400.0));
+                double result = static_cast<size_t>(winningSide) == a ? 1.0 : static_cast<size_t>(winningSide) == b ? 0.0 : 0.5;
+                sideDelta[a] += K * (result - expected);
+                sideDelta[b] -= K * (result - expected);
+            }
+        }
+
+        // рейтинги меняются после разбора всей игры; доля побед ключа — среднее по его местам
+        std::vector<double> delta(ratings.size(), 0.0);
+        std::vector<double> won(ratings.size(), 0.0);
+        std::vector<int> seats(ratings.size(), 0);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            size_t own = static_cast<size_t>(side[i]);
+            delta[keys[i]] += sideDelta[own] / sideSize[own];
+            won[keys[i]] += side[i] == winningSide ? 1.0 : 0.0;
+            ++seats[keys[i]];
+        }
+        for (size_t key = 0; key < ratings.size(); ++key) {
+            if (seats[key] > 0) {
+                ratings[key] += delta[key];
+                scores[key] += won[key] / seats[key];
+                ++games[key];
+            }
+        }
+    }
+
+    double rating(size_t key) const { return ratings[key]; }
+    std::uint64_t gamesPlayed(size_t key) const { return games[key]; }
+
+    // средний результат за игру, доля побед
+    double score(size_t key) const { return games[key] ? scores[key] / games[key] : 0.0; }
+
+    // полуширина 95% интервала рейтинга. Рейтинг — это логит доли побед, умноженный на 400/ln 10,
+    // так что по дельта-методу sigma = 400 / (ln 10 * sqrt(n p (1 - p)))
+    double confidence(size_t key) const {
+        if (games[key] == 0) {
+            return std::numeric_limits<double>::infinity();
+        }
+        double n = static_cast<double>(games[key]);
+        double p = std::clamp(score(key), 0.5 / n, 1.0 - 0.5 / n);
+        return 1.96 * 400.0 / (std::log(10.0) * std::sqrt(n * p * (1.0 - p)));
+    }
+
+private:
+    std::vector<double> ratings;
+    std::vector<std::uint64_t> games;
+    std::vector<double> scores;
+};
+
+struct TournamentResult {
+    std::vector<std::string> roster;
+    long long games = 0;
+    EloTable overall;   // ключ — номер стратегии в составе
+    EloTable byRole;    // ключ — номер стратегии * RoleCount + роль
+
+    explicit TournamentResult(std::vector<std::string> roster)
+        : roster(std::move(roster)), overall(this->roster.size()), byRole(this->roster.size() * RoleCount) {}
+};
+
+// поток генератора состава, не пересекается с потоками ботов (их номера меньше 2^31)
+constexpr std::uint64_t LineupStream = std::uint64_t{1} << 40;
+
+// места игры по стратегиям: места перемешиваются сидом игры и раздаются стратегиям по кругу,
+// а начало круга сдвигается от игры к игре, так что лишние места достаются всем по очереди.
+// Роли раздает игра, поэтому в среднем у каждой стратегии одинаковые доли всех ролей
+inline std::vector<std::uint8_t> tournamentLineup(int numPlayers, size_t rosterSize, long long gameIndex, std::uint64_t gameSeed) {
+    std::vector<int> seats(numPlayers);
+    for (int i = 0; i < numPlayers; ++i) {
+        seats[i] = i;
+    }
+    SplitMix64 lineupRng(SplitMix64::streamSeed(gameSeed, LineupStream));
+    std::shuffle(seats.begin(), seats.end(), lineupRng);
+
+    std::vector<std::uint8_t> lineup(numPlayers);
+    for (int i = 0; i < numPlayers; ++i) {
+        lineup[seats[i]] = static_cast<std::uint8_t>((i + gameIndex) % static_cast<long long>(rosterSize));
+    }
+    return lineup;
+}
+
+// играет numGames игр на numThreads потоках, как runSimulation: игра i получает сид baseSeed + i.
+// Рейтинги пересчитываются после всех игр в порядке номеров, поэтому от числа потоков не зависят
+inline TournamentResult runTournament(const std::vector<const StrategyEntry*>& roster, long long numGames, int numThreads,
+                                      int numPlayers, const std::vector<std::string>& names, std::uint64_t baseSeed,
+                                      cppcoro::static_thread_pool* decisionPool) {
+    std::vector<std::string> rosterNames;
+    for (const StrategyEntry* entry : roster) {
+        rosterNames.push_back(entry->name);
+    }
+    TournamentResult result(std::move(rosterNames));
+
+    // итог каждой игры: победитель и для каждого места стратегия и роль
+    std::vector<Winner> winners(numGames, Winner::None);
+    std::vector<std::uint8_t> seatStrategies(static_cast<size_t>(numGames) * numPlayers);
+    std::vector<Role> seatRoles(static_cast<size_t>(numGames) * numPlayers);
+
+    std::atomic<long long> nextGame{0};
+    std::vector<std::thread> workers;
+    for (int t = 0; t < numThreads; ++t) {
+        workers.emplace_back([&] {
+            GameArena arena;
+            for (long long gameIndex = nextGame.fetch_add(1, std::memory_order_relaxed); gameIndex < numGames;
+                 gameIndex = nextGame.fetch_add(1, std::memory_order_relaxed)) {
+                {
+                    std::uint64_t gameSeed = baseSeed + gameIndex;
+                    std::vector<std::uint8_t> lineup = tournamentLineup(numPlayers, roster.size(), gameIndex, gameSeed);
+                    auto strategies = [&](PlayerId id, std::uint64_t seed, std::pmr::memory_resource* resource) {
+                        return roster[lineup[id]]->create(resource, id, seed);
+                    };
+                    GameMaster game(arena, numPlayers, false, names, gameSeed, true, strategies);
+                    game.setDecisionPool(decisionPool);
+                    game.runGame();
+
+                    winners[gameIndex] = game.getWinner();
+                    size_t offset = static_cast<size_t>(gameIndex) * numPlayers;
+                    for (const auto& player : game.getPlayers()) {
+                        seatStrategies[offset + player->getId()] = lineup[player->getId()];
+                        seatRoles[offset + player->getId()] = player->getRole();
+                    }
+                }
+                arena.reset();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<size_t> strategyKeys(numPlayers), roleKeys(numPlayers);
+    std::vector<Faction> sides(numPlayers);
+    for (long long gameIndex = 0; gameIndex < numGames; ++gameIndex) {
+        if (winners[gameIndex] == Winner::None) {
+            continue;
+        }
+        Faction winningSide = winners[gameIndex] == Winner::Mafia       ? Faction::Mafia
+                              : winners[gameIndex] == Winner::Civilians ? Faction::Civilians
+                                                                        : Faction::Maniac;
+        size_t offset = static_cast<size_t>(gameIndex) * numPlayers;
+        for (int seat = 0; seat < numPlayers; ++seat) {
+            Role role = seatRoles[offset + seat];
+            strategyKeys[seat] = seatStrategies[offset + seat];
+            roleKeys[seat] = strategyKeys[seat] * RoleCount + static_cast<size_t>(role);
+            sides[seat] = roleTraits(role).faction;
+        }
+        result.overall.playGame(strategyKeys, sides, winningSide);
+        result.byRole.playGame(roleKeys, sides, winningSide);
+        ++result.games;
+    }
+    return result;
+}
+
+// стратегии по убыванию общего рейтинга
+inline std::vector<size_t> leaderboardOrder(const TournamentResult& result) {
+    std::vector<size_t> order(result.roster.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) { return result.overall.rating(a) > result.overall.rating(b); });
+    return order;
+}
+
+inline void printLeaderboard(const TournamentResult& result) {
+    std::cout << "\n========== ТУРНИР СТРАТЕГИЙ ==========\n";
+    std::cout << "Сыграно игр: " << result.games << "\n";
+    std::cout << std::fixed << std::setprecision(1);
+    int place = 1;
+    for (size_t strategy : leaderboardOrder(result)) {
+        std::cout << place++ << ". " << result.roster[strategy] << ": " << result.overall.rating(strategy) << " ± "
+                  << result.overall.confidence(strategy) << ", побед " << 100.0 * result.overall.score(strategy) << "%\n";
+        for (size_t role = 0; role < RoleCount; ++role) {
+            size_t key = strategy * RoleCount + role;
+            if (result.byRole.gamesPlayed(key) == 0) {
+                continue;
+            }
+            std::cout << "   " << std::setw(16) << std::left << roleTraitsTable[role].key << std::right << result.byRole.rating(key)
+                      << " ± " << result.byRole.confidence(key) << ", побед " << 100.0 * result.byRole.score(key) << "% в "
+                      << result.byRole.gamesPlayed(key) << " играх\n";
+        }
+    }
+    const auto& mcts = MctsStrategy::throughput();
+    if (mcts.rollouts.load() > 0) {
+        std::cout << "MCTS: " << mcts.rollouts.load() << " доигрываний, " << mcts.rolloutsPerSecond() << " в секунду на решение\n";
+    }
+    std::cout << "======================================\n";
+    std::cout.unsetf(std::ios::floatfield);
+}
+
+// таблица лидеров в JSON: ci95 — полуширина 95% интервала рейтинга, null — игр не было
+inline bool writeLeaderboard(const std::string& path, const TournamentResult& result, std::uint64_t seed) {
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    auto rated = [&](const EloTable& table, size_t key) {
+        out << "\"rating\": " << table.rating(key) << ", \"ci95\": ";
+        // без игр интервал бесконечен, а inf в JSON не бывает
+        if (table.gamesPlayed(key) == 0) {
+            out << "null";
+        } else {
+            out << table.confidence(key);
+        }
+        out << ", \"win_rate\": " << table.score(key) << ", \"games\": " << table.gamesPlayed(key);
+    };
+    out << std::setprecision(6) << std::fixed;
+    out << "{\n  \"tournament\": \"MafiaGame\",\n  \"seed\": " << seed << ",\n  \"games\": " << result.games
+        << ",\n  \"mcts_rollouts_per_second\": " << MctsStrategy::throughput().rolloutsPerSecond() << ",\n  \"leaderboard\": [\n";
+    std::vector<size_t> order = leaderboardOrder(result);
+    for (size_t i = 0; i < order.size(); ++i) {
+        size_t strategy = order[i];
+        out << "    {\"strategy\": \"" << result.roster[strategy] << "\", ";
+        rated(result.overall, strategy);
+        out << ", \"roles\": {";
+        bool first = true;
+        for (size_t role = 0; role < RoleCount; ++role) {
+            size_t key = strategy * RoleCount + role;
+            if (result.byRole.gamesPlayed(key) == 0) {
+                continue;
+            }
+            out << (first ? "" : ", ") << "\"" << roleTraitsTable[role].key << "\": {";
+            rated(result.byRole, key);
+            out << "}";
+            first = false;
+        }
+        out << "}}" << (i + 1 < order.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+#endif // TOURNAMENT_H
@@ -1,877 +1,365 @@
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
-#include "MySharedPtr.h"
-#include <concepts>
-#include <unordered_map>
-#include "Logger.h"
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <memory>
 #include <random>
-#include <algorithm>
-#include <ranges>
-#include <functional>
-#include <cppcoro/task.hpp>
-#include <cppcoro/when_all.hpp>
-#include <cppcoro/sync_wait.hpp>
-#include <fstream>
-#include <iostream>
-
-class Player;
-class PlayerStrategy;
-
-MySharedPtr<Player> getRandomPlayer(const std::vector<MySharedPtr<Player>>& candidates);
-
-
-class PlayerStrategy {
-public:
-    virtual ~PlayerStrategy() = default;
-
-    virtual cppcoro::task<std::string> vote(
-        const std::vector<MySharedPtr<Player>>& players,
-        const std::function<bool(const MySharedPtr<Player>&)> targetFilter) = 0;
-
-    virtual cppcoro::task<std::pair<std::string, std::string>> chooseAction(
-        const std::vector<MySharedPtr<Player>>& players, 
-        const std::vector<std::string>& availableActions,
-        const std::function<bool(const MySharedPtr<Player>&)> targetFilter) = 0;
-};
-
-class Player {
-public:
-    Player(const std::string& name, MySharedPtr<PlayerStrategy> strategy) 
-        : playerName(name), alive(true), strategy(strategy) {}
-
-    virtual ~Player() = default;
-
-    virtual cppcoro::task<std::string> vote(const std::vector<MySharedPtr<Player>>& players) {        
-        // не голосуем против себя
-        auto targetFilter = [this](const MySharedPtr<Player>& player) {
-            return player->isAlive() && player.get() != this;
-        };
-
-        return strategy->vote(players, targetFilter);
-    }
-
-    virtual cppcoro::task<std::pair<std::string, std::string>> nightAction(
-        const std::vector<MySharedPtr<Player>>& players) = 0;
-
-    std::string getName() const { return playerName; }
-    bool isAlive() const { return alive; }
-    void die() { alive = false; }
-    MySharedPtr<PlayerStrategy> getStrategy() const { return strategy; }
-
-protected:
-    std::string playerName;
-    bool alive;
-    MySharedPtr<PlayerStrategy> strategy;
-};
-
-class BotStrategy : public PlayerStrategy {
-public:
-    cppcoro::task<std::string> vote(
-        const std::vector<MySharedPtr<Player>>& players,
-        const std::function<bool(const MySharedPtr<Player>&)> targetFilter) override {
-        
-        auto potentialTargets = players | std::ranges::views::filter(targetFilter);
-        std::vector<MySharedPtr<Player>> filteredPlayers(potentialTargets.begin(), potentialTargets.end());
-
-        auto target = getRandomPlayer(filteredPlayers);
-        if (target) {
-            co_return target->getName();
+#include <cstdlib>
+#include <charconv>
+#include <limits>
+#include <sstream>
+#include <cppcoro/static_thread_pool.hpp>
+#include "Game.h"
+#include "Tournament.h"
+#ifdef MAFIA_COUNT_ALLOCATIONS
+#include "AllocationCounterHooks.h"
+#endif
+
+struct SimulationStats {
+    long long games = 0;
+    long long mafiaWins = 0;
+    long long civilianWins = 0;
+    long long maniacWins = 0;
+    long long totalDays = 0;
+    std::uint64_t setupAllocations = 0;  // выделения в куче при создании игр
+    std::uint64_t phaseAllocations = 0;  // выделения в куче внутри фаз
+    long long phases = 0;
+
+    void add(const GameMaster& game, std::uint64_t gameSetupAllocations) {
+        ++games;
+        totalDays += game.getCurrentDay();
+        setupAllocations += gameSetupAllocations;
+        phaseAllocations += game.getPhaseAllocations();
+        phases += game.getPhasesPlayed();
+        switch (game.getWinner()) {
+            case Winner::Mafia: ++mafiaWins; break;
+            case Winner::Civilians: ++civilianWins; break;
+            case Winner::Maniac: ++maniacWins; break;
+            case Winner::None: break;
         }
-        
-        co_return "";
     }
 
-
-    cppcoro::task<std::pair<std::string, std::string>> chooseAction(
-        const std::vector<MySharedPtr<Player>>& players, 
-        const std::vector<std::string>& availableActions,
-        const std::function<bool(const MySharedPtr<Player>&)> targetFilter) override {
-        
-        auto potentialTargets = players 
-            | std::ranges::views::filter(targetFilter);
-        std::vector<MySharedPtr<Player>> filteredPlayers(potentialTargets.begin(), potentialTargets.end());
-
-        auto target = getRandomPlayer(filteredPlayers);
-        if (target && !availableActions.empty()) {
-            std::string action = availableActions[rand() % availableActions.size()];
-            co_return std::make_pair(action, target->getName());
-        }
-        co_return std::make_pair("", "");
+    void merge(const SimulationStats& other) {
+        games += other.games;
+        mafiaWins += other.mafiaWins;
+        civilianWins += other.civilianWins;
+        maniacWins += other.maniacWins;
+        totalDays += other.totalDays;
+        setupAllocations += other.setupAllocations;
+        phaseAllocations += other.phaseAllocations;
+        phases += other.phases;
     }
 };
 
-class UserStrategy : public PlayerStrategy {
-public:
-    cppcoro::task<std::string> vote(
-        const std::vector<MySharedPtr<Player>>& players,
-        const std::function<bool(const MySharedPtr<Player>&)> targetFilter) override {
-        
-        std::cout << "Введите имя игрока, за которого хотите проголосовать: ";
-        std::string choice;
-        std::cin >> choice;
-
-        auto it = std::find_if(players.begin(), players.end(), [&](const MySharedPtr<Player>& player) {
-            return player->getName() == choice && targetFilter(player);
-        });
-
-        if (it != players.end()) {
-            co_return choice;
-        }
-        co_return "";
-    }
-
-    cppcoro::task<std::pair<std::string, std::string>> chooseAction(
-        const std::vector<MySharedPtr<Player>>& players, 
-        const std::vector<std::string>& availableActions,
-        const std::function<bool(const MySharedPtr<Player>&)> targetFilter) override {
-        
-        std::cout << "Введите имя игрока, с которым хотите совершить действие: ";
-        std::string target;
-        std::cin >> target;
-
-        std::cout << "Доступные действия:\n";
-        for (const auto& action : availableActions) {
-            std::cout << "- " << action << "\n";
-        }
-        std::cout << "Введите действие: ";
-        std::string action;
-        std::cin >> action;
-
-        auto it = std::find_if(players.begin(), players.end(), [&](const MySharedPtr<Player>& player) {
-            return player->getName() == target && targetFilter(player);
+// прогоняет numGames независимых игр ботов на numThreads потоках, каждый поток берет следующую игру из общего счетчика.
+// игра с номером i получает сид baseSeed + i, поэтому результат не зависит от числа потоков.
+// у каждого потока своя арена, она сбрасывается целиком после каждой игры
+SimulationStats runSimulation(long long numGames, int numThreads, int numPlayers, const std::vector<std::string>& names,
+                              std::uint64_t baseSeed, const std::string& eventLogPath,
+                              cppcoro::static_thread_pool* decisionPool) {
+    std::atomic<long long> nextGame{0};
+    std::vector<SimulationStats> threadStats(numThreads);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < numThreads; ++t) {
+        workers.emplace_back([&, t] {
+            SimulationStats& stats = threadStats[t];
+            GameArena arena;
+            for (long long gameIndex = nextGame.fetch_add(1, std::memory_order_relaxed); gameIndex < numGames;
+                 gameIndex = nextGame.fetch_add(1, std::memory_order_relaxed)) {
+                {
+                    std::uint64_t allocationsBefore = AllocationCounter::count();
+                    GameMaster game(arena, numPlayers, false, names, baseSeed + gameIndex, true);
+                    std::uint64_t setupAllocations = AllocationCounter::count() - allocationsBefore;
+                    if (!eventLogPath.empty()) {
+                        game.enableEventLog(eventLogPath);
+                    }
+                    game.setDecisionPool(decisionPool);
+                    game.runGame();
+                    stats.add(game, setupAllocations);
+                }
+                arena.reset();
+            }
         });
-
-        if (it != players.end() && std::find(availableActions.begin(), availableActions.end(), action) != availableActions.end()) {
-            co_return std::make_pair(action, target);
-        }
-        co_return std::make_pair("", "");
     }
-};
-
 
-std::vector<std::string> loadNames(const std::string& fileName) {
-    std::ifstream file(fileName);
-    std::vector<std::string> names;
-    std::string name;
-
-    if (!file) {
-        std::cerr << "Не удалось открыть файл с именами.\n";
-        return names;
+    for (auto& worker : workers) {
+        worker.join();
     }
 
-    while (std::getline(file, name)) {
-        if (!name.empty()) {
-            names.push_back(name);
-        }
+    SimulationStats total;
+    for (const auto& stats : threadStats) {
+        total.merge(stats);
     }
-
-    file.close();
-    return names;
+    return total;
 }
 
-MySharedPtr<Player> getRandomPlayer(const std::vector<MySharedPtr<Player>>& candidates) {
-    if (candidates.empty()) {
-        return nullptr;
-    }
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distr(0, candidates.size() - 1);
-
-    return candidates[distr(gen)];
+void printSimulationStats(const SimulationStats& stats, double seconds) {
+    auto percent = [&](long long wins) {
+        return stats.games ? 100.0 * wins / stats.games : 0.0;
+    };
+
+    std::cout << "\n========== РЕЗУЛЬТАТЫ СИМУЛЯЦИИ ==========\n";
+    std::cout << "Сыграно игр: " << stats.games << "\n";
+    std::cout << "Победы мафии: " << stats.mafiaWins << " (" << percent(stats.mafiaWins) << "%)\n";
+    std::cout << "Победы мирных жителей: " << stats.civilianWins << " (" << percent(stats.civilianWins) << "%)\n";
+    std::cout << "Победы маньяка: " << stats.maniacWins << " (" << percent(stats.maniacWins) << "%)\n";
+    std::cout << "Средняя длина игры (дней): " << (stats.games ? static_cast<double>(stats.totalDays) / stats.games : 0.0) << "\n";
+    std::cout << "Игр в секунду: " << (seconds > 0 ? stats.games / seconds : 0.0) << "\n";
+#ifdef MAFIA_COUNT_ALLOCATIONS
+    std::cout << "Выделений памяти в куче: " << (stats.games ? static_cast<double>(stats.setupAllocations) / stats.games : 0.0)
+              << " на создание игры, " << (stats.phases ? static_cast<double>(stats.phaseAllocations) / stats.phases : 0.0)
+              << " на фазу\n";
+#endif
+    std::cout << "==========================================\n";
 }
 
-class Doctor : public Player {
-public:
-    Doctor(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Player(name, strategy), lastHealed("") {}
-
-    cppcoro::task<std::pair<std::string, std::string>> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
-        std::vector<std::string> actions = {"heal"};
+// потоков и секунд больше этого не бывает нужно, а большие числа переполнили бы длительности
+constexpr int MaxThreads = 1024;
+constexpr double MaxSeconds = 24 * 60 * 60;
+
+// число из командной строки целиком, без пробелов и хвоста; false — не число или вне [min, max]
+template <typename T>
+bool parseNumber(std::string_view text, T& value, T min, T max) {
+    T parsed{};
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), parsed);
+    // сравнение так, чтобы nan не прошел
+    if (error != std::errc() || end != text.data() + text.size() || !(parsed >= min && parsed <= max)) {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
 
-        auto targetFilter = [this](const MySharedPtr<Player>& player) {
-            return player->isAlive() && player->getName() != lastHealed;
-        };
+void printUsage(std::ostream& out, const char* program) {
+    out << "Использование: " << program << " [параметры]\n"
+        << "  --simulate N            сыграть N игр ботов без консоли и вывести статистику\n"
+        << "  --threads N             потоков симуляции (1.." << MaxThreads << ")\n"
+        << "  --players N             игроков в симуляции, не меньше 5\n"
+        << "  --seed N                сид игры или первой игры симуляции\n"
+        << "  --events PATH           дописывать бинарный журнал событий\n"
+        << "  --turn-seconds S        сколько ждать ход человека; 0 — сколько угодно\n"
+        << "  --checkpoint PATH       снимок игры перед каждой фазой\n"
+        << "  --resume PATH           продолжить игру со снимка\n"
+        << "  --name-base NAME        имена NAME1, NAME2, ... вместо names.txt\n"
+        << "  --tournament A,B,...    турнир стратегий, число игр — --simulate\n"
+        << "  --leaderboard PATH      куда писать таблицу лидеров турнира\n"
+        << "  --mcts-rollouts N       доигрываний на решение mcts; 0 — только по времени\n"
+        << "  --mcts-ms T             миллисекунд на решение mcts; 0 — без ограничения\n"
+        << "  --mcts-threads N        потоков пула mcts (1.." << MaxThreads << ")\n"
+        << "  --decision-threads N    потоков для решений игроков внутри фазы; 0 — по очереди\n"
+        << "  --metrics PREFIX        куда писать метрики: PREFIX.json и PREFIX.prom;\n"
+        << "                          расширение отбрасывается, m.json тоже дает m.json и m.prom\n"
+        << "  --verbosity LEVEL       silent, summary или full\n"
+        << "  --quiet                 то же, что --verbosity silent\n"
+        << "  --log-level LEVELS      off, summary, detail или day=...,night=...,result=...\n"
+        << "  --log-flush-ms T        как часто сбрасывать логи на диск\n";
+}
 
-        auto [action, target] = co_await strategy->chooseAction(players, actions, targetFilter);
-        if (action == "heal") {
-            lastHealed = target;
+int main(int argc, char* argv[]) {
+    long long numGamesToSimulate = 0;
+    int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    int numSimulatedPlayers = 10;
+    std::uint64_t seed = std::random_device()();
+    std::string eventLogPath;
+    int numDecisionThreads = 0;
+    std::string checkpointPath;
+    std::string resumePath;
+    std::string nameBase;
+    std::string tournamentRoster;
+    std::string leaderboardPath = "leaderboard.json";
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--quiet") {
+            // то же, что --verbosity silent
+            ConsoleRenderer::sharedOptions().verbosity = Verbosity::Silent;
+            continue;
         }
-        co_return std::make_pair(action, target);
-    }
-
-private:
-    std::string lastHealed;  // не лечим одного и того же игрока два раза подряд
-};
-
-
-class Mafia : public Player {
-public:
-    Mafia(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Player(name, strategy) {}
-
-    cppcoro::task<std::pair<std::string, std::string>> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
-        std::vector<std::string> actions = {"kill"};
-
-        auto targetFilter = [this](const MySharedPtr<Player>& player) {
-            return player->isAlive() && !isAlliedWith(player);
-        };
-
-        auto [action, target] = co_await strategy->chooseAction(players, actions, targetFilter);
-        co_return std::make_pair(action, target);
-    }
-
-    cppcoro::task<std::string> vote(const std::vector<MySharedPtr<Player>>& players) override {
-        // мафия не голосует против мафии
-        auto targetFilter = [this](const MySharedPtr<Player>& player) {
-            return player->isAlive() && !isAlliedWith(player) && player.get() != this;
-        };
-
-        return strategy->vote(players, targetFilter);
-    }
-
-protected:
-    bool isAlliedWith(const MySharedPtr<Player>& player) const {
-        return dynamic_cast<Mafia*>(player.get()) != nullptr;
-    }
-};
-
-class Bull : public Mafia {
-public:
-    Bull(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Mafia(name, strategy) {}
-};
-
-class Ninja : public Mafia {
-public:
-    Ninja(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Mafia(name, strategy) {}
-};
-
-class Killer : public Mafia {
-public:
-    Killer(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Mafia(name, strategy) {}
-};
-
-class Civilian : public Player {
-public:
-    Civilian(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Player(name, strategy) {}
-
-    cppcoro::task<std::pair<std::string, std::string>> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
-        // мирный житель ночью ничего не делает
-        co_return std::make_pair("", "");
-    }
-};
-
-
-class Maniac : public Player {
-public:
-    Maniac(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Player(name, strategy) {}
-
-    cppcoro::task<std::pair<std::string, std::string>> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
-        std::vector<std::string> actions = {"kill"};
-
-        auto targetFilter = [this](const MySharedPtr<Player>& player) {
-            return player->isAlive() && player.get() != this;
-        };
-
-        auto [action, target] = co_await strategy->chooseAction(players, actions, targetFilter);
-        co_return std::make_pair(action, target);
-    }
-};
-
-
-class Commissar : public Player {
-public:
-    Commissar(const std::string& name, MySharedPtr<PlayerStrategy> strategy)
-        : Player(name, strategy) {}
-
-    void addCheckedPlayer(const std::string& playerName, bool isMafia) {
-        checkedPlayers[playerName] = isMafia;
-    }
-
-    cppcoro::task<std::pair<std::string, std::string>> nightAction(const std::vector<MySharedPtr<Player>>& players) override {
-        std::vector<std::string> actions = {"check", "kill"};
-
-        // комиссар может сделать действие над всеми, кроме себя и проверенных мирных
-        auto targetFilter = [this](const MySharedPtr<Player>& player) {
-            return player->isAlive() && player.get() != this && !isCheckedAndInnocent(player->getName());
-        };
-
-        auto [action, target] = co_await strategy->chooseAction(players, actions, targetFilter);
-        co_return std::make_pair(action, target);
-    }
-
-    // не голосует против проверенных мирных
-    cppcoro::task<std::string> vote(const std::vector<MySharedPtr<Player>>& players) override {
-        auto targetFilter = [this](const MySharedPtr<Player>& player) {
-            return player->isAlive() && player.get() != this && !isCheckedAndInnocent(player->getName());
-        };
-
-        return strategy->vote(players, targetFilter);
-    }
-
-private:
-    // имя игрока и статус (true — мафия, false — мирный)
-    std::unordered_map<std::string, bool> checkedPlayers;
-
-    bool isCheckedAndInnocent(const std::string& playerName) const {
-        auto it = checkedPlayers.find(playerName);
-        return it != checkedPlayers.end() && !it->second;
-    }
-};
-
-
-
-class GameMaster {
-public:
-    GameMaster(int numPlayers, bool isUserPlayer)
-        : numPlayers(numPlayers), isUserPlayer(isUserPlayer), currentDay(1) {
-        assignRoles();
-    }
-
-    void runGame() {
-        while (!isGameOver()) {
-            playDayPhase();
-            if (isGameOver()) break;
-            
-            playNightPhase();
-            announceNightResults();
-            ++currentDay;
+        if (arg == "--help") {
+            printUsage(std::cout, argv[0]);
+            return 0;
         }
-    }
-
-private:
-    int numPlayers;
-    bool isUserPlayer;
-    int currentDay;
-    std::vector<MySharedPtr<Player>> players;
-    std::vector<std::string> playersToReveal;
-    std::vector<std::string> healedPlayers;
-
-    Logger logger;
-
-
-
-    void assignRandomRole(const std::string& playerName, int& numMafia, int& numDoctors, int& numCommissars, int& numManiacs, int& numCivilians, 
-                      std::vector<std::string>& mafiaNames, bool& bullAssigned, bool& ninjaAssigned, bool& killerAssigned) {
-    int randomRole = std::rand() % (numMafia + numDoctors + numCommissars + numManiacs + numCivilians);
-    std::string assignedRole;
-    
-    if (randomRole < numMafia) {
-        int mafiaType = std::rand() % 4;
-        
-        if (mafiaType == 0 || (bullAssigned && ninjaAssigned && killerAssigned)) {
-            players.push_back(MySharedPtr<Mafia>(new Mafia(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-            assignedRole = "мафия";
-        } else if (mafiaType == 1 && !bullAssigned) {
-            players.push_back(MySharedPtr<Bull>(new Bull(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-            assignedRole = "бык";
-            bullAssigned = true; 
-        } else if (mafiaType == 2 && !ninjaAssigned) {
-            players.push_back(MySharedPtr<Ninja>(new Ninja(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-            assignedRole = "ниндзя";
-            ninjaAssigned = true; 
-        } else if (mafiaType == 3 && !killerAssigned) {
-            players.push_back(MySharedPtr<Killer>(new Killer(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-            assignedRole = "киллер";
-            killerAssigned = true; 
-        } else {
-            players.push_back(MySharedPtr<Mafia>(new Mafia(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-            assignedRole = "мафия";
+        if (i + 1 >= argc) {
+            std::cerr << "Не указано значение для " << arg << ".\n";
+            printUsage(std::cerr, argv[0]);
+            return 1;
         }
-        
-        mafiaNames.push_back(playerName);
-        numMafia--;
-    } else if (randomRole < numMafia + numDoctors) {
-        players.push_back(MySharedPtr<Doctor>(new Doctor(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-        assignedRole = "доктор";
-        numDoctors--;
-    } else if (randomRole < numMafia + numDoctors + numCommissars) {
-        players.push_back(MySharedPtr<Commissar>(new Commissar(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-        assignedRole = "комиссар";
-        numCommissars--;
-    } else if (randomRole < numMafia + numDoctors + numCommissars + numManiacs) {
-        players.push_back(MySharedPtr<Maniac>(new Maniac(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-        assignedRole = "маньяк";
-        numManiacs--;
-    } else {
-        players.push_back(MySharedPtr<Civilian>(new Civilian(playerName, MySharedPtr<BotStrategy>(new BotStrategy()))));
-        assignedRole = "мирный житель";
-        numCivilians--;
-    }
-
-    logger.logDayAction(0, playerName + " получил роль: " + assignedRole);
-}
-
-
-
-void assignRoles() {
-    std::vector<std::string> names = loadNames("../names.txt");
-
-    if (names.size() < numPlayers) {
-        std::cerr << "\n*** Недостаточно имен в файле для игры. Минимум " << numPlayers << ". ***\n";
-        return;
-    }
-
-    std::shuffle(names.begin(), names.end(), std::mt19937(std::random_device()()));
-
-    int numMafia = std::max(1, numPlayers / 5);
-    int numDoctors = 1;
-    int numCommissars = 1;
-    int numManiacs = 1;
-    int numCivilians = numPlayers - numMafia - numDoctors - numCommissars - numManiacs;
-
-    std::vector<std::string> mafiaNames;
-
-    bool bullAssigned = false;
-    bool ninjaAssigned = false;
-    bool killerAssigned = false;
-
-    if (isUserPlayer) {
-        std::string playerName;
-        std::cout << "Введите свое имя: ";
-        std::cin >> playerName;
-        std::cout << "Выберите роль (mafia, bull, ninja, killer, doctor, commissar, maniac, civilian) или нажмите Enter для случайного выбора: ";
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        std::string role;
-        std::getline(std::cin, role);
-
-        std::string assignedRole;
-
-        if (role == "mafia") {
-            players.push_back(MySharedPtr<Mafia>(new Mafia(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            mafiaNames.push_back(playerName);
-            assignedRole = "мафия";
-            numMafia--;
-        } else if (role == "bull" && !bullAssigned) {
-            players.push_back(MySharedPtr<Bull>(new Bull(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            mafiaNames.push_back(playerName);
-            assignedRole = "бык";
-            bullAssigned = true;
-            numMafia--;
-        } else if (role == "ninja" && !ninjaAssigned) {
-            players.push_back(MySharedPtr<Ninja>(new Ninja(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            mafiaNames.push_back(playerName);
-            assignedRole = "ниндзя";
-            ninjaAssigned = true;
-            numMafia--;
-        } else if (role == "killer" && !killerAssigned) {
-            players.push_back(MySharedPtr<Killer>(new Killer(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            mafiaNames.push_back(playerName);
-            assignedRole = "киллер";
-            killerAssigned = true;
-            numMafia--;
-        } else if (role == "doctor") {
-            players.push_back(MySharedPtr<Doctor>(new Doctor(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            assignedRole = "доктор";
-            numDoctors--;
-        } else if (role == "commissar") {
-            players.push_back(MySharedPtr<Commissar>(new Commissar(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            assignedRole = "комиссар";
-            numCommissars--;
-        } else if (role == "maniac") {
-            players.push_back(MySharedPtr<Maniac>(new Maniac(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            assignedRole = "маньяк";
-            numManiacs--;
-        } else if (role == "civilian") {
-            players.push_back(MySharedPtr<Civilian>(new Civilian(playerName, MySharedPtr<UserStrategy>(new UserStrategy()))));
-            assignedRole = "мирный житель";
-            numCivilians--;
+        bool valid = true;  // false — значение числового параметра не разобралось
+        if (arg == "--simulate") {
+            valid = parseNumber(argv[++i], numGamesToSimulate, 0LL, std::numeric_limits<long long>::max());
+        } else if (arg == "--threads") {
+            valid = parseNumber(argv[++i], numThreads, 1, MaxThreads);
+        } else if (arg == "--players") {
+            valid = parseNumber(argv[++i], numSimulatedPlayers, 5, std::numeric_limits<int>::max());
+        } else if (arg == "--seed") {
+            valid = parseNumber(argv[++i], seed, std::uint64_t{0}, std::numeric_limits<std::uint64_t>::max());
+        } else if (arg == "--events") {
+            eventLogPath = argv[++i];
+        } else if (arg == "--turn-seconds") {
+            // сколько ждать ход человека, потом за него решает бот; 0 — ждать сколько угодно
+            double seconds = 0;
+            valid = parseNumber(argv[++i], seconds, 0.0, MaxSeconds);
+            ConsoleInput::sharedOptions().turnTimeout = std::chrono::milliseconds(std::llround(seconds * 1000));
+        } else if (arg == "--checkpoint") {
+            // перед каждой фазой обычной игры снимок пишется в этот файл
+            checkpointPath = argv[++i];
+        } else if (arg == "--resume") {
+            resumePath = argv[++i];
+        } else if (arg == "--name-base") {
+            // имена игроков base1, base2, ... вместо names.txt — для лобби больше списка имен
+            nameBase = argv[++i];
+        } else if (arg == "--tournament") {
+            // стратегии через запятую; --simulate задает число игр турнира
+            tournamentRoster = argv[++i];
+        } else if (arg == "--leaderboard") {
+            leaderboardPath = argv[++i];
+        } else if (arg == "--mcts-rollouts") {
+            // бюджет решения стратегии mcts: доигрываний и (или) миллисекунд; 0 — без этого ограничения
+            valid = parseNumber(argv[++i], MctsStrategy::sharedOptions().rollouts, 0, std::numeric_limits<int>::max());
+        } else if (arg == "--mcts-ms") {
+            double milliseconds = 0;
+            valid = parseNumber(argv[++i], milliseconds, 0.0, MaxSeconds * 1000);
+            MctsStrategy::sharedOptions().timeBudget = std::chrono::microseconds(std::llround(milliseconds * 1000));
+        } else if (arg == "--mcts-threads") {
+            valid = parseNumber(argv[++i], MctsStrategy::sharedOptions().threads, 1, MaxThreads);
+        } else if (arg == "--decision-threads") {
+            valid = parseNumber(argv[++i], numDecisionThreads, 0, MaxThreads);
+        } else if (arg == "--metrics") {
+            // куда при выходе писать метрики: <prefix>.json и <prefix>.prom, расширение в prefix отбрасывается
+            Metrics::sharedOptions().outputPrefix = argv[++i];
+        } else if (arg == "--verbosity") {
+            // silent, summary или full: сколько игра пишет в консоль
+            if (!verbosityFromKey(argv[++i], ConsoleRenderer::sharedOptions().verbosity)) {
+                std::cerr << "Неизвестный уровень вывода: " << argv[i] << " (silent, summary, full).\n";
+                return 1;
+            }
+        } else if (arg == "--log-level") {
+            // off, summary, detail для всех логов или day=...,night=...,result=... по отдельности
+            if (!parseLogLevels(argv[++i], Logger::sharedOptions())) {
+                std::cerr << "Некорректный уровень логов: " << argv[i] << " (off, summary, detail или day=...,night=...,result=...).\n";
+                return 1;
+            }
+        } else if (arg == "--log-flush-ms") {
+            // как часто фоновый писатель сбрасывает логи на диск
+            long long milliseconds = 0;
+            valid = parseNumber(argv[++i], milliseconds, 0LL, static_cast<long long>(MaxSeconds * 1000));
+            AsyncLogWriter::sharedOptions().flushInterval = std::chrono::milliseconds(milliseconds);
         } else {
-            
-            assignRandomRole(playerName, numMafia, numDoctors, numCommissars, numManiacs, numCivilians, mafiaNames, bullAssigned, ninjaAssigned, killerAssigned);
+            std::cerr << "Неизвестный параметр: " << arg << "\n";
+            printUsage(std::cerr, argv[0]);
+            return 1;
+        }
+        if (!valid) {
+            std::cerr << "Некорректное значение для " << arg << ": " << argv[i] << "\n";
+            printUsage(std::cerr, argv[0]);
+            return 1;
         }
-
-        
-        logger.logDayAction(0, playerName + " получил роль: " + assignedRole);
-
-        
-        names.erase(std::remove(names.begin(), names.end(), playerName), names.end());
-    }
-
-    
-    for (const auto& name : names) {
-        assignRandomRole(name, numMafia, numDoctors, numCommissars, numManiacs, numCivilians, mafiaNames, bullAssigned, ninjaAssigned, killerAssigned);
-        if (players.size() == numPlayers) break;
     }
 
-    
-    if (isUserPlayer && std::find(mafiaNames.begin(), mafiaNames.end(), players.front()->getName()) != mafiaNames.end()) {
-        std::cout << "\nВы — мафиози! Вот список всех мафиози:\n";
-        for (const auto& name : mafiaNames) {
-            if (name != players.front()->getName()) {
-                std::cout << "- " << name << "\n";
-            }
+#ifdef MAFIA_METRICS
+    std::atexit([] {
+        if (!Metrics::writeFiles()) {
+            std::cerr << "Не удалось записать метрики в " << Metrics::outputBase() << ".json/.prom\n";
         }
-    }
+    });
+#endif
 
-    std::cout << "\n========== ИГРОКИ В ЭТОЙ ИГРЕ ==========\n";
-    for (const auto& player : players) {
-        std::cout << "- " << player->getName() << std::endl;
+    std::vector<std::string> names;
+    if (nameBase.empty()) {
+        names = loadNames("../names.txt");
     }
-    std::cout << "=========================================\n" << std::endl;
-}
-    
 
-    void addPlayerToReveal(const std::string& playerName) {
-        if (std::find(playersToReveal.begin(), playersToReveal.end(), playerName) == playersToReveal.end()) {
-            playersToReveal.push_back(playerName);
-        }
+    // пул для решений игроков внутри фазы, по умолчанию решения идут по очереди на потоке игры
+    std::unique_ptr<cppcoro::static_thread_pool> decisionPool;
+    if (numDecisionThreads > 0) {
+        decisionPool = std::make_unique<cppcoro::static_thread_pool>(numDecisionThreads);
     }
 
-  void playNightPhase() {
-        std::string mafiaVictim, killerVictim, maniacVictim, doctorHeal, commissarAction, commissarTarget;
-        MySharedPtr<Player> commissarPlayer;
-        std::unordered_map<std::string, int> mafiaVotes;
-
-        std::string logMessage = "НОЧЬ " + std::to_string(currentDay) + " НАСТУПИЛА. Начались ночные действия.\n";
-
-        std::vector<cppcoro::task<std::pair<std::string, std::string>>> nightTasks;
-        std::vector<MySharedPtr<Player>> alivePlayers;
-
-        for (auto& player : players | std::ranges::views::filter([](const MySharedPtr<Player>& p) { return p->isAlive(); })) {
-            alivePlayers.push_back(player);
-            nightTasks.push_back(player->nightAction(players));
+    if (numGamesToSimulate > 0) {
+        if (!nameBase.empty()) {
+            names = generateNames(std::max(numSimulatedPlayers, 5), nameBase);
+        }
+        if (numSimulatedPlayers < 5 || numSimulatedPlayers > static_cast<int>(names.size()) || numThreads < 1) {
+            std::cerr << "Некорректные параметры симуляции: нужно от 5 до " << names.size()
+                      << " игроков (больше — с --name-base) и хотя бы один поток.\n";
+            return 1;
         }
 
-        auto results = cppcoro::sync_wait(cppcoro::when_all(std::move(nightTasks)));
-
-        for (size_t i = 0; i < alivePlayers.size(); ++i) {
-            const auto& action = results[i];
-            const std::string& actionType = action.first;
-            const std::string& target = action.second;
-            auto currentPlayer = alivePlayers[i];
-
-            if (!actionType.empty() && !target.empty()) {
-                logMessage += currentPlayer->getName() + " совершает действие: " + actionType + " на " + target + ".\n";
-            }
-
-            if (actionType == "kill") {
-                if (dynamic_cast<Mafia*>(currentPlayer.get()) && !dynamic_cast<Killer*>(currentPlayer.get())) {
-                    mafiaVotes[target]++;
-                } else if (dynamic_cast<Killer*>(currentPlayer.get())) {
-                    killerVictim = target;
-                } else if (dynamic_cast<Maniac*>(currentPlayer.get())) {
-                    auto victim = findPlayerByName(target);
-                    if (victim && dynamic_cast<Bull*>(victim.get())) {
-                        logMessage += "Маньяк попытался убить " + target + ", но это был Бык, и он не был убит.\n";
-                    } else {
-                        maniacVictim = target;
+        if (!tournamentRoster.empty()) {
+            std::vector<const StrategyEntry*> roster;
+            std::stringstream list(tournamentRoster);
+            std::string name;
+            while (std::getline(list, name, ',')) {
+                const StrategyEntry* entry = StrategyRegistry::shared().find(name);
+                if (!entry) {
+                    std::cerr << "Неизвестная стратегия: " << name << ". Доступны:";
+                    for (const auto& known : StrategyRegistry::shared().all()) {
+                        std::cerr << " " << known.name;
                     }
-                } else if (dynamic_cast<Commissar*>(currentPlayer.get())) {
-                    commissarPlayer = currentPlayer;
-                    commissarAction = actionType;
-                    commissarTarget = target;
+                    std::cerr << "\n";
+                    return 1;
                 }
-            } else if (actionType == "heal" && dynamic_cast<Doctor*>(currentPlayer.get())) {
-                doctorHeal = target;
-            } else if (actionType == "check" && dynamic_cast<Commissar*>(currentPlayer.get())) {
-                commissarPlayer = currentPlayer;
-                commissarAction = actionType;
-                commissarTarget = target;
+                roster.push_back(entry);
             }
-        }
-
-        int maxVotes = 0;
-        for (const auto& [name, count] : mafiaVotes) {
-            if (count > maxVotes) {
-                maxVotes = count;
-                mafiaVictim = name;
-            } else if (count == maxVotes) {
-                if (std::rand() % 2 == 0) {
-                    mafiaVictim = name;
-                }
+            if (roster.empty()) {
+                std::cerr << "В турнире нужна хотя бы одна стратегия.\n";
+                return 1;
             }
-        }
-
-        if (!mafiaVictim.empty()) {
-            logMessage += "Мафия выбрала жертву: " + mafiaVictim + ".\n";
-        }
-        if (!killerVictim.empty()) {
-            logMessage += "Киллер выбрал жертву: " + killerVictim + ".\n";
-        }
-        if (!doctorHeal.empty()) {
-            if (mafiaVictim == doctorHeal || killerVictim == doctorHeal || maniacVictim == doctorHeal) {
-                healedPlayers.push_back(doctorHeal);
+            // номер стратегии места хранится в uint8
+            if (roster.size() > std::numeric_limits<std::uint8_t>::max()) {
+                std::cerr << "В турнире не больше " << int{std::numeric_limits<std::uint8_t>::max()} << " стратегий.\n";
+                return 1;
             }
-            logMessage += "Доктор лечит: " + doctorHeal + ".\n";
-        }
-
-        if (!maniacVictim.empty()) {
-            logMessage += "Маньяк выбрал жертву: " + maniacVictim + ".\n";
-        }
-
-        if (!mafiaVictim.empty() && mafiaVictim != doctorHeal) {
-            killPlayer(mafiaVictim);
-            addPlayerToReveal(mafiaVictim);
-            logMessage += "Мафия убила: " + mafiaVictim + ".\n";
-        }
-        if (!killerVictim.empty() && killerVictim != doctorHeal) {
-            killPlayer(killerVictim);
-            addPlayerToReveal(killerVictim);
-            logMessage += "Киллер убил: " + killerVictim + ".\n";
-        }
 
-        if (!maniacVictim.empty() && maniacVictim != doctorHeal) {
-            killPlayer(maniacVictim);
-            addPlayerToReveal(maniacVictim);
-            logMessage += "Маньяк убил: " + maniacVictim + ".\n";
-        }
-
-        
-        if (!commissarTarget.empty()) {
-            if (commissarAction == "kill" && commissarTarget != doctorHeal) {
-                killPlayer(commissarTarget);
-                addPlayerToReveal(commissarTarget);
-                logMessage += "Комиссар убил: " + commissarTarget + ".\n";
-            } else if (commissarAction == "check") {
-                auto targetPlayer = findPlayerByName(commissarTarget);
-                if (targetPlayer) {
-                        bool isMafia = dynamic_cast<Mafia*>(targetPlayer.get()) != nullptr && dynamic_cast<Ninja*>(targetPlayer.get()) == nullptr;                    if (Commissar* commissar = dynamic_cast<Commissar*>(commissarPlayer.get())) {
-                        commissar->addCheckedPlayer(commissarTarget, isMafia);
-                        
-                        logMessage += "Комиссар проверил: " + commissarTarget + ". Это " + (isMafia ? "мафия." : "не мафия.") + "\n";
-
-                        if (dynamic_cast<UserStrategy*>(commissar->getStrategy().get())) {
-                            std::cout << "\nРезультат проверки: " << commissarTarget << " — ";
-                            if (isMafia) {
-                                std::cout << "мафия." << std::endl;
-                            } else {
-                                std::cout << "не мафия." << std::endl;
-                            }
-                        }
-                    }
-                }
+            TournamentResult result = runTournament(roster, numGamesToSimulate, numThreads, numSimulatedPlayers, names, seed,
+                                                    decisionPool.get());
+            std::cout << "Сиды игр: " << seed << " .. " << seed + numGamesToSimulate - 1 << "\n";
+            printLeaderboard(result);
+            if (!writeLeaderboard(leaderboardPath, result, seed)) {
+                std::cerr << "Не удалось записать таблицу лидеров в " << leaderboardPath << ".\n";
+                return 1;
             }
+            std::cout << "Таблица лидеров записана в " << leaderboardPath << "\n";
+            return 0;
         }
-        logger.logNightAction(currentDay, logMessage);
-    }
-
-
 
+        auto start = std::chrono::steady_clock::now();
+        SimulationStats stats = runSimulation(numGamesToSimulate, numThreads, numSimulatedPlayers, names, seed, eventLogPath,
+                                              decisionPool.get());
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
 
-
-    MySharedPtr<Player> findPlayerByName(const std::string& name) {
-        auto it = std::find_if(players.begin(), players.end(), [&](const MySharedPtr<Player>& player) {
-            return player->getName() == name;
-        });
-        return (it != players.end()) ? *it : nullptr;
+        std::cout << "Сиды игр: " << seed << " .. " << seed + numGamesToSimulate - 1 << "\n";
+        printSimulationStats(stats, elapsed.count());
+        return 0;
     }
 
-    void killPlayer(const std::string& name) {
-        auto player = findPlayerByName(name);
-        if (player) {
-            player->die();
-        }
-    }
+    GameArena arena;
 
-    void announceNightResults() {
-        std::cout << "\n========== РЕЗУЛЬТАТЫ НОЧИ ==========\n";
-        for (const auto& playerName : playersToReveal) {
-            auto player = findPlayerByName(playerName);
-            if (player) {
-                std::cout << "\n*** " << playerName << " был убит прошлой ночью. Он был ";
-                if (dynamic_cast<Mafia*>(player.get())) {
-                    std::cout << "мафией. ***\n";
-                } else if (dynamic_cast<Doctor*>(player.get())) {
-                    std::cout << "доктором. ***\n";
-                } else if (dynamic_cast<Commissar*>(player.get())) {
-                    std::cout << "комиссаром. ***\n";
-                } else if (dynamic_cast<Maniac*>(player.get())) {
-                    std::cout << "маньяком. ***\n";
-                } else {
-                    std::cout << "мирным жителем. ***\n";
-                }
-            }
+    if (!resumePath.empty()) {
+        GameSnapshot snapshot;
+        if (!loadSnapshot(resumePath, snapshot)) {
+            std::cerr << "Не удалось прочитать снимок игры из " << resumePath << ".\n";
+            return 1;
         }
-
-        for (const auto& playerName : healedPlayers) {
-            std::cout << "\n*** " << playerName << " был спасен прошлой ночью доктором. ***\n";
+        std::cout << "Игра продолжается с дня " << snapshot.currentDay << (snapshot.nightNext ? ", ночь" : "")
+                  << " (сид " << snapshot.seed << ")\n";
+        GameMaster gameMaster(arena, snapshot);
+        if (!eventLogPath.empty()) {
+            gameMaster.enableEventLog(eventLogPath);
         }
-        std::cout << "======================================\n" << std::endl;
-        playersToReveal.clear();
-        healedPlayers.clear();
-    }
-
-   bool isGameOver() {
-    int numMafia = std::ranges::count_if(players, [](const MySharedPtr<Player>& player) {
-        return player->isAlive() && dynamic_cast<Mafia*>(player.get()) != nullptr;
-    });
-
-    int numCivilians = std::ranges::count_if(players, [](const MySharedPtr<Player>& player) {
-        return player->isAlive() && !dynamic_cast<Mafia*>(player.get()) && !dynamic_cast<Maniac*>(player.get());
-    });
-
-    int numManiac = std::ranges::count_if(players, [](const MySharedPtr<Player>& player) {
-        return player->isAlive() && dynamic_cast<Maniac*>(player.get()) != nullptr;
-    });
-
-    std::string logMessage = "РЕЗУЛЬТАТЫ ИГРЫ:\n";
-
-    if (numMafia > numCivilians) {
-        std::cout << "\n*** Мафия победила! Количество мафов больше количества мирных жителей. ***\n";
-        std::cout << "Осталось:\n"
-                  << "- Мафия: " << numMafia << "\n"
-                  << "- Мирные жители: " << numCivilians << "\n";
-
-        logMessage += "Мафия победила. Количество мафов больше количества мирных жителей.\n";
-        logMessage += "Остаток мафии: " + std::to_string(numMafia) + "\nОстаток мирных жителей: " + std::to_string(numCivilians) + "\n";
-        logFinalResult(logMessage);
-        return true;
-    }
-
-    if (numMafia == numCivilians && numManiac == 0) {
-        std::cout << "\n*** Мафия победила! Количество мафов равно количеству мирных жителей. ***\n";
-        std::cout << "Осталось:\n"
-                  << "- Мафия: " << numMafia << "\n"
-                  << "- Мирные жители: " << numCivilians << "\n";
-
-        logMessage += "Мафия победила. Количество мафов равно количеству мирных жителей.\n";
-        logMessage += "Остаток мафии: " + std::to_string(numMafia) + "\nОстаток мирных жителей: " + std::to_string(numCivilians) + "\n";
-        logFinalResult(logMessage);
-        return true;
-    }
-
-    if (numMafia == 0 && numManiac == 0) {
-        std::cout << "\n*** Мирные жители победили! Все мафы и маньяк убиты. ***\n";
-        std::cout << "Осталось:\n"
-                  << "- Мирные жители: " << numCivilians << "\n";
-
-        logMessage += "Мирные жители победили. Все мафы и маньяк убиты.\n";
-        logMessage += "Остаток мирных жителей: " + std::to_string(numCivilians) + "\n";
-        logFinalResult(logMessage);
-        return true;
-    }
-
-    if (numManiac == 1 && numMafia == 0 && numCivilians == 1) {
-        std::cout << "\n*** Маньяк победил! Он остался один на один с мирным жителем. ***\n";
-        std::cout << "Осталось:\n"
-                  << "- Маньяк: 1\n"
-                  << "- Мирные жители: 1\n";
-
-        logMessage += "Маньяк победил. Он остался один на один с мирным жителем.\n";
-        logMessage += "Остаток маньяка: 1\nОстаток мирных жителей: 1\n";
-        logFinalResult(logMessage);
-        return true;
-    }
-
-    return false;
-}
-
-void logFinalResult(const std::string& logMessage) {
-    std::string finalLog = logMessage + "СОСТОЯНИЕ ИГРОКОВ:\n";
-    for (const auto& player : players) {
-        std::string role;
-
-        if (dynamic_cast<Mafia*>(player.get())) {
-            role = "Мафия";
-        } else if (dynamic_cast<Doctor*>(player.get())) {
-            role = "Доктор";
-        } else if (dynamic_cast<Commissar*>(player.get())) {
-            role = "Комиссар";
-        } else if (dynamic_cast<Maniac*>(player.get())) {
-            role = "Маньяк";
-        } else if (dynamic_cast<Civilian*>(player.get())) {
-            role = "Мирный житель";
-        }
-
-        finalLog += "Имя: " + player->getName() + ", Роль: " + role + ", Статус: " + (player->isAlive() ? "Жив" : "Мертв") + "\n";
-    }
-
-    finalLog += "=====================================\n";
-    logger.logResult(finalLog);
-}
-
-
-   void playDayPhase() {
-    std::cout << "\n********** ДЕНЬ " << currentDay << " НАСТУПИЛ **********\n";
-    std::unordered_map<std::string, int> voteCount;
-    std::unordered_map<std::string, std::string> playerVotes;
-
-    std::vector<cppcoro::task<std::string>> voteTasks;
-    for (auto& player : players | std::ranges::views::filter([](const MySharedPtr<Player>& p) { return p->isAlive(); })) {
-        voteTasks.push_back(player->vote(players));
-    }
-
-    auto results = cppcoro::sync_wait(cppcoro::when_all(std::move(voteTasks)));
-
-    std::string logMessage = "ДЕНЬ " + std::to_string(currentDay) + " НАСТУПИЛ. Началось голосование.\n";
-
-    int index = 0;
-    for (auto& player : players | std::ranges::views::filter([](const MySharedPtr<Player>& p) { return p->isAlive(); })) {
-        const auto& target = results[index++];
-        if (!target.empty()) {
-            voteCount[target]++;
-            playerVotes[player->getName()] = target;
-            logMessage += "Игрок " + player->getName() + " голосует за " + target + ".\n";
-        }
-    }
-
-    std::cout << "\n========== ДНЕВНОЕ ГОЛОСОВАНИЕ ==========\n";
-    for (const auto& [voter, target] : playerVotes) {
-        std::cout << voter << " голосует за " << target << "\n";
-    }
-    std::cout << "------------------------------------------\n";
-    
-    std::cout << "РЕЗУЛЬТАТЫ ГОЛОСОВАНИЯ:\n";
-    for (const auto& [name, count] : voteCount) {
-        std::cout << name << ": " << count << "\n";
-        logMessage += name + " получил " + std::to_string(count) + " голосов.\n";
-    }
-    std::cout << "==========================================\n" << std::endl;
-
-    std::string eliminatedPlayer;
-    int maxVotes = 0;
-    for (const auto& [name, count] : voteCount) {
-        if (count > maxVotes) {
-            maxVotes = count;
-            eliminatedPlayer = name;
-        } else if (count == maxVotes) {
-            if (std::rand() % 2 == 0) {
-                eliminatedPlayer = name;
-            }
+        if (!checkpointPath.empty()) {
+            gameMaster.enableCheckpoints(checkpointPath);
         }
+        gameMaster.setDecisionPool(decisionPool.get());
+        gameMaster.runGame();
+        return 0;
     }
 
-    if (!eliminatedPlayer.empty()) {
-        auto it = std::find_if(players.begin(), players.end(), [&](const MySharedPtr<Player>& p) {
-            return p->getName() == eliminatedPlayer;
-        });
-
-        if (it != players.end()) {
-            (*it)->die();
-            std::cout << "*** " << eliminatedPlayer << " был казнен днем. ***\n";
-
-            if (dynamic_cast<Mafia*>((*it).get())) {
-                std::cout << "*** Он был мафией. ***\n";
-                logMessage += "\nИгрок " + eliminatedPlayer + " был казнен и он был мафией.\n";
-            } else {
-                std::cout << "*** Он был не мафией. ***\n";
-                logMessage += "\nИгрок " + eliminatedPlayer + " был казнен и он был не мафией.\n";
-            }
-            
-            logMessage += "\nИгрок " + eliminatedPlayer + " был исключен с " + std::to_string(maxVotes) + " голосами.\n";
-        }
-    } else {
-        logMessage += "\nНикто не был исключен.\n";
-    }
-
-    logger.logDayAction(currentDay, logMessage);
-
-    std::cout << "**************************************\n";
-}
-
-
-
-};
-
-
-int main() {
     int numPlayers;
     char userChoice;
 
@@ -882,13 +370,25 @@ int main() {
         std::cerr << "Недостаточно игроков для игры. Минимум 5.\n";
         return 1;
     }
+    if (!nameBase.empty()) {
+        names = generateNames(numPlayers, nameBase);
+    }
 
     std::cout << "Вы хотите участвовать в игре? (y/n): ";
     std::cin >> userChoice;
 
     bool isUserPlayer = (userChoice == 'y' || userChoice == 'Y');
 
-    GameMaster gameMaster(numPlayers, isUserPlayer);
+    std::cout << "Сид игры: " << seed << " (повторить: --seed " << seed << ")\n";
+
+    GameMaster gameMaster(arena, numPlayers, isUserPlayer, names, seed);
+    if (!eventLogPath.empty()) {
+        gameMaster.enableEventLog(eventLogPath);
+    }
+    if (!checkpointPath.empty()) {
+        gameMaster.enableCheckpoints(checkpointPath);
+    }
+    gameMaster.setDecisionPool(decisionPool.get());
     gameMaster.runGame();
 
     return 0;
@@ -0,0 +1,256 @@
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "EventLog.h"
+
+// чтение бинарного журнала событий без разбора текста: файл отображается в память целиком
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* mapped = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                data = mapped;
+                size = static_cast<size_t>(st.st_size);
+                madvise(data, size, MADV_SEQUENTIAL);
+            }
+        }
+        close(fd);
+    }
+
+    ~MappedFile() {
+        if (data) {
+            munmap(data, size);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return data != nullptr; }
+    const void* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    void* data = nullptr;
+    size_t size = 0;
+};
+
+const char* roleName(std::uint32_t role) {
+    return role < RoleCount ? roleTraits(static_cast<Role>(role)).name : "?";
+}
+
+const char* winnerName(std::uint32_t winner) {
+    static const char* names[] = {"никто", "мафия", "мирные жители", "маньяк"};
+    return winner < std::size(names) ? names[winner] : "?";
+}
+
+std::string playerLabel(std::uint32_t id) {
+    if (id == NoEventPlayer) {
+        return "-";
+    }
+    std::string label = "#";
+    label += std::to_string(id);
+    return label;
+}
+
+struct Summary {
+    std::uint64_t games = 0;
+    std::uint64_t events = 0;
+    std::uint64_t totalDays = 0;
+    std::array<std::uint64_t, 4> wins{};
+    std::uint64_t nightKills = 0;
+    std::uint64_t nightKillsPrevented = 0;
+    std::uint64_t heals = 0;
+    std::uint64_t saves = 0;
+    std::uint64_t checks = 0;
+    std::uint64_t checksFoundMafia = 0;
+    std::uint64_t executions = 0;
+    std::uint64_t executedMafia = 0;
+};
+
+void summarizeGame(const EventLogCursor::Game& game, Summary& summary) {
+    // роли нужны, чтобы понять, кого казнили; векторы переиспользуются между играми
+    static std::vector<std::uint8_t> roles;
+    // погибшие ночью: если одну жертву выбрали двое, событий убийства два, а жертва одна
+    static std::vector<std::uint8_t> killed;
+    roles.assign(game.header.numPlayers, 0);
+    killed.assign(game.header.numPlayers, 0);
+
+    ++summary.games;
+    summary.events += game.header.numEvents;
+
+    for (std::uint32_t i = 0; i < game.header.numEvents; ++i) {
+        const EventRecord& event = game.events[i];
+        switch (event.action) {
+            case EventAction::AssignRole:
+                if (event.actor < roles.size()) {
+                    roles[event.actor] = static_cast<std::uint8_t>(event.outcome);
+                }
+                break;
+            case EventAction::Execute:
+                ++summary.executions;
+                if (event.target < roles.size() && roles[event.target] < RoleCount &&
+                    isMafiaRole(static_cast<Role>(roles[event.target]))) {
+                    ++summary.executedMafia;
+                }
+                break;
+            case EventAction::Kill:
+                if (!event.outcome) {
+                    ++summary.nightKillsPrevented;
+                } else if (event.target >= killed.size()) {
+                    ++summary.nightKills;
+                } else if (!killed[event.target]) {
+                    killed[event.target] = 1;
+                    ++summary.nightKills;
+                }
+                break;
+            case EventAction::Heal:
+                ++summary.heals;
+                summary.saves += event.outcome;
+                break;
+            case EventAction::Check:
+                ++summary.checks;
+                summary.checksFoundMafia += event.outcome;
+                break;
+            case EventAction::GameOver:
+                summary.totalDays += event.day;
+                if (event.outcome < summary.wins.size()) {
+                    ++summary.wins[event.outcome];
+                }
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+void printSummary(const Summary& summary) {
+    auto percent = [](std::uint64_t part, std::uint64_t total) {
+        return total ? 100.0 * part / total : 0.0;
+    };
+
+    std::cout << "Игр: " << summary.games << ", событий: " << summary.events << "\n";
+    for (std::uint32_t w = 1; w < summary.wins.size(); ++w) {
+        std::cout << "Победы (" << winnerName(w) << "): " << summary.wins[w]
+                  << " (" << percent(summary.wins[w], summary.games) << "%)\n";
+    }
+    std::cout << "Средняя длина игры (дней): " << (summary.games ? static_cast<double>(summary.totalDays) / summary.games : 0.0) << "\n";
+    std::cout << "Казней: " << summary.executions << ", из них мафии: " << percent(summary.executedMafia, summary.executions) << "%\n";
+    std::cout << "Ночных убийств: " << summary.nightKills << ", предотвращено: " << summary.nightKillsPrevented << "\n";
+    std::cout << "Лечений: " << summary.heals << ", спасено: " << summary.saves << "\n";
+    std::cout << "Проверок комиссара: " << summary.checks << ", найдена мафия: " << percent(summary.checksFoundMafia, summary.checks) << "%\n";
+}
+
+void replayGame(const EventLogCursor::Game& game) {
+    std::cout << "Сид: " << game.header.seed << ", игроков: " << game.header.numPlayers << "\n";
+    for (std::uint32_t i = 0; i < game.header.numEvents; ++i) {
+        const EventRecord& e = game.events[i];
+        std::string actor = playerLabel(e.actor);
+        std::string target = playerLabel(e.target);
+        switch (e.action) {
+            case EventAction::AssignRole:
+                std::cout << actor << " получил роль: " << roleName(e.outcome) << "\n";
+                break;
+            case EventAction::Vote:
+                std::cout << "День " << e.day << ": " << actor << " голосует за " << target << "\n";
+                break;
+            case EventAction::Execute:
+                std::cout << "День " << e.day << ": " << target << " казнен (" << e.outcome << " голосов)\n";
+                break;
+            case EventAction::MafiaVote:
+                std::cout << "Ночь " << e.day << ": мафиози " << actor << " выбирает " << target << "\n";
+                break;
+            case EventAction::Kill:
+                std::cout << "Ночь " << e.day << ": " << actor << " убивает " << target << (e.outcome ? "" : " — неудачно") << "\n";
+                break;
+            case EventAction::Heal:
+                std::cout << "Ночь " << e.day << ": " << actor << " лечит " << target << (e.outcome ? " и спасает" : "") << "\n";
+                break;
+            case EventAction::Check:
+                std::cout << "Ночь " << e.day << ": " << actor << " проверяет " << target << " — " << (e.outcome ? "мафия" : "не мафия") << "\n";
+                break;
+            case EventAction::GameOver:
+                std::cout << "Игра окончена на день " << e.day << ", победитель: " << winnerName(e.outcome) << "\n";
+                break;
+        }
+    }
+}
+
+int printUsage(const char* program) {
+    std::cerr << "Использование:\n"
+              << "  " << program << " summary <журнал>...\n"
+              << "  " << program << " replay <журнал> <номер игры>\n";
+    return 1;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        return printUsage(argv[0]);
+    }
+
+    std::string command = argv[1];
+
+    if (command == "summary") {
+        Summary summary;
+        for (int i = 2; i < argc; ++i) {
+            MappedFile file(argv[i]);
+            if (!file.isOpen()) {
+                std::cerr << "Не удалось открыть " << argv[i] << "\n";
+                return 1;
+            }
+            EventLogCursor cursor(file.getData(), file.getSize());
+            EventLogCursor::Game game;
+            while (cursor.next(game)) {
+                summarizeGame(game, summary);
+            }
+            if (cursor.isCorrupted()) {
+                std::cerr << "Журнал " << argv[i] << " поврежден, прочитано игр: " << summary.games << "\n";
+            }
+        }
+        printSummary(summary);
+        return 0;
+    }
+
+    if (command == "replay" && argc >= 4) {
+        std::string_view number = argv[3];
+        unsigned long long wanted = 0;
+        auto [end, error] = std::from_chars(number.data(), number.data() + number.size(), wanted);
+        if (error != std::errc() || end != number.data() + number.size()) {
+            std::cerr << "Номер игры должен быть неотрицательным целым: " << number << "\n";
+            return printUsage(argv[0]);
+        }
+        MappedFile file(argv[2]);
+        if (!file.isOpen()) {
+            std::cerr << "Не удалось открыть " << argv[2] << "\n";
+            return 1;
+        }
+        EventLogCursor cursor(file.getData(), file.getSize());
+        EventLogCursor::Game game;
+        for (unsigned long long index = 0; cursor.next(game); ++index) {
+            if (index == wanted) {
+                replayGame(game);
+                return 0;
+            }
+        }
+        std::cerr << "Игра " << wanted << " не найдена.\n";
+        return 1;
+    }
+
+    std::cerr << "Неизвестная команда: " << command << "\n";
+    return 1;
+}